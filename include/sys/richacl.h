@@ -23,6 +23,7 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <linux/richacl.h>
 
@@ -50,6 +51,32 @@ struct richacl {
 	struct richace  a_entries[0];
 };
 
+/*
+ * Effective permissions of a principal: @e_flags is RICHACE_SPECIAL_WHO for
+ * owner@, group@, and everyone@ (with the special id in @e_id), and
+ * RICHACE_IDENTIFIER_GROUP for groups.
+ */
+struct richacl_effective {
+	unsigned short	e_flags;
+	unsigned int	e_mask;
+	id_t		e_id;
+};
+
+/*
+ * Richacl xattr value checked by richacl_xattr_view_init(), for looking at
+ * without decoding it.  The xattr value must remain valid while the view
+ * is in use.
+ */
+struct richacl_xattr_view {
+	const void	*v_value;
+	const char	*v_who;
+	unsigned char	v_flags;
+	unsigned short	v_count;
+	unsigned int	v_owner_mask;
+	unsigned int	v_group_mask;
+	unsigned int	v_other_mask;
+};
+
 #define richacl_for_each_entry(_ace, _acl) \
 	for ((_ace) = (_acl)->a_entries; \
 	     (_ace) != (_acl)->a_entries + (_acl)->a_count; \
@@ -69,12 +96,47 @@ struct richacl {
 #define RICHACL_TEXT_ALIGN		32
 #define RICHACL_TEXT_NUMERIC_IDS	64
 
+/* richacl_shape flags */
+#define RICHACL_SHAPE_MASKED		1
+#define RICHACL_SHAPE_WRITE_THROUGH	2
+#define RICHACL_SHAPE_ALLOW_ONLY	4
+#define RICHACL_SHAPE_SPECIAL_ONLY	8
+#define RICHACL_SHAPE_NO_INHERIT_ONLY	16
+#define RICHACL_SHAPE_ALL		31
+
 /* richacl_from_text flags */
 #define RICHACL_TEXT_OWNER_MASK		1
 #define RICHACL_TEXT_GROUP_MASK		2
 #define RICHACL_TEXT_OTHER_MASK		4
 #define RICHACL_TEXT_FLAGS		8
 
+/* richace_class values */
+#define RICHACE_CLASS_OWNER		RICHACE_OWNER_SPECIAL_ID
+#define RICHACE_CLASS_GROUP		RICHACE_GROUP_SPECIAL_ID
+#define RICHACE_CLASS_EVERYONE		RICHACE_EVERYONE_SPECIAL_ID
+#define RICHACE_CLASS_UID		3
+#define RICHACE_CLASS_GID		4
+#define RICHACE_CLASS_UNMAPPED		5
+#define RICHACE_CLASS_INVALID		6
+
+/*
+ * Which kind of principal an entry applies to, for switching on in loops
+ * over acl entries instead of calling the richace_is_*() functions one
+ * after the other.  Unlike richace_is_unix_user() and
+ * richace_is_unix_group(), entries with an unmapped identifier are in a
+ * class of their own.
+ */
+static inline unsigned int richace_class(const struct richace *ace)
+{
+	if (ace->e_flags & RICHACE_SPECIAL_WHO)
+		return ace->e_id <= RICHACE_EVERYONE_SPECIAL_ID ?
+		       ace->e_id : RICHACE_CLASS_INVALID;
+	if (ace->e_flags & RICHACE_UNMAPPED_WHO)
+		return RICHACE_CLASS_UNMAPPED;
+	return (ace->e_flags & RICHACE_IDENTIFIER_GROUP) ?
+	       RICHACE_CLASS_GID : RICHACE_CLASS_UID;
+}
+
 extern bool richace_is_owner(const struct richace *);
 extern bool richace_is_group(const struct richace *);
 extern bool richace_is_everyone(const struct richace *);
@@ -122,8 +184,13 @@ extern int richace_copy(struct richace *, const struct richace *);
 
 extern struct richacl *richacl_get_file(const char *);
 extern struct richacl *richacl_get_fd(int);
+extern struct richacl *richacl_get_file_buffer(const char *, void *, size_t);
+extern struct richacl *richacl_get_fd_buffer(int, void *, size_t);
 extern int richacl_set_file(const char *, const struct richacl *);
 extern int richacl_set_fd(int, const struct richacl *);
+extern struct richacl *richacl_get_at(int, const char *, int);
+extern int richacl_set_at(int, const char *, const struct richacl *, int);
+extern int richacl_set_xattr_at(int, const char *, const void *, size_t, int);
 
 extern char *richacl_to_text(const struct richacl *, int);
 extern struct richacl *richacl_from_text(const char *, int *,
@@ -142,11 +209,167 @@ extern struct richacl *richacl_inherit(const struct richacl *, int isdir);
 extern int richacl_equiv_mode(const struct richacl *, mode_t *);
 extern int richacl_compare(const struct richacl *, const struct richacl *);
 
+struct richacl_cred;
+extern struct richacl_cred *richacl_cred_alloc(uid_t, const gid_t *, int);
+extern void richacl_cred_free(struct richacl_cred *);
+
 struct stat;
 extern int richacl_access(const char *, const struct stat *, uid_t,
 			  const gid_t *, int);
+extern int richacl_access_cred(const char *, const struct stat *,
+			       const struct richacl_cred *);
+
+/*
+ * Scratch buffer size for richacl_access_buffer().  An xattr value takes 16
+ * bytes plus 12 bytes per entry and the length of any unmapped identifiers,
+ * so this is sufficient for acls with up to 84 entries.
+ */
+#define RICHACL_ACCESS_BUFFER_SIZE	1024
+extern int richacl_access_buffer(const char *, const struct stat *,
+				 const struct richacl_cred *, void *, size_t);
 extern bool richacl_permission(struct richacl *, uid_t, gid_t, uid_t, const gid_t *,
 			       int, unsigned int);
+extern bool richacl_permission_cred(const struct richacl *, uid_t, gid_t,
+				    const struct richacl_cred *, unsigned int);
+extern int richacl_permission_many(const struct richacl *, uid_t, gid_t,
+				   const struct richacl_cred *const *,
+				   unsigned int, unsigned int, bool *);
+extern void richacl_permission_vec(const struct richacl_cred *,
+				   const struct richacl *const *,
+				   const uid_t *, const gid_t *,
+				   unsigned int, unsigned int, bool *);
+extern unsigned int richacl_shape(const struct richacl *);
+extern bool richacl_permission_shape(const struct richacl *, unsigned int,
+				     uid_t, gid_t,
+				     const struct richacl_cred *,
+				     unsigned int);
+extern struct richacl_effective *richacl_effective(const struct richacl *,
+						   const struct stat *,
+						   unsigned int *);
+
+struct richacl_store;
+extern struct richacl_store *richacl_store_alloc(void);
+extern void richacl_store_free(struct richacl_store *);
+extern void richacl_store_stats(struct richacl_store *, unsigned long *,
+				unsigned long *, unsigned long *);
+extern const struct richacl *richacl_intern(struct richacl_store *,
+					    const struct richacl *);
+extern const struct richacl *richacl_intern_get(const struct richacl *);
+extern void richacl_intern_put(const struct richacl *);
+
+struct richacl_cache;
+extern struct richacl_cache *richacl_cache_alloc(unsigned int);
+extern void richacl_cache_free(struct richacl_cache *);
+extern void richacl_cache_stats(struct richacl_cache *, unsigned long *,
+				unsigned long *);
+extern bool richacl_permission_cache(struct richacl_cache *,
+				     const struct richacl *, uid_t, gid_t,
+				     const struct richacl_cred *,
+				     unsigned int);
+extern int richacl_access_cache(struct richacl_cache *, const char *,
+				const struct stat *,
+				const struct richacl_cred *);
+
+struct richacl_masks_cache;
+extern struct richacl_masks_cache *richacl_masks_cache_alloc(struct richacl_store *,
+							     unsigned int);
+extern void richacl_masks_cache_free(struct richacl_masks_cache *);
+extern void richacl_masks_cache_stats(struct richacl_masks_cache *,
+				      unsigned long *, unsigned long *);
+extern const struct richacl *richacl_apply_masks_cache(struct richacl_masks_cache *,
+						       const struct richacl *,
+						       uid_t);
+
+struct richacl_remask;
+extern struct richacl_remask *richacl_remask_alloc(const struct richacl *, uid_t);
+extern void richacl_remask_free(struct richacl_remask *);
+extern struct richacl *richacl_remask(struct richacl_remask *, unsigned int,
+				      unsigned int, unsigned int);
+
+struct richacl_builder;
+extern struct richacl_builder *richacl_builder_alloc(struct richacl *);
+extern void richacl_builder_free(struct richacl_builder *);
+extern struct richacl *richacl_builder_acl(struct richacl_builder *);
+extern int richacl_builder_reserve(struct richacl_builder *, unsigned int);
+extern int richacl_builder_insert(struct richacl_builder *,
+				  const unsigned int *,
+				  const struct richace *, unsigned int);
+extern void richacl_builder_delete(struct richacl_builder *,
+				   const unsigned int *, unsigned int);
+extern int richacl_builder_replace(struct richacl_builder *,
+				   const unsigned int *,
+				   const struct richace *, unsigned int);
+extern struct richacl *richacl_builder_finish(struct richacl_builder *);
+
+struct richacl_compiled;
+extern struct richacl_compiled *richacl_compile(const struct richacl *);
+extern void richacl_compiled_free(struct richacl_compiled *);
+extern bool richacl_compiled_permission(const struct richacl_compiled *, uid_t,
+					gid_t, uid_t, const gid_t *, int,
+					unsigned int);
+extern bool richacl_compiled_permission_cred(const struct richacl_compiled *,
+					     uid_t, gid_t,
+					     const struct richacl_cred *,
+					     unsigned int);
+
+struct richacl_packed;
+extern struct richacl_packed *richacl_pack(const struct richacl *);
+extern struct richacl *richacl_unpack(const struct richacl_packed *);
+extern void richacl_packed_free(struct richacl_packed *);
+extern bool richacl_packed_permission(const struct richacl_packed *, uid_t,
+				      gid_t, const struct richacl_cred *,
+				      unsigned int);
+extern int richacl_packed_compare(const struct richacl_packed *,
+				  const struct richacl_packed *);
+extern uint64_t richacl_packed_hash(const struct richacl_packed *);
+extern uint64_t richacl_hash(const struct richacl *);
+extern int richacl_xattr_hash(const void *, size_t, uint64_t *);
+extern bool richacl_equal(const struct richacl *, const struct richacl *);
+
+/*
+ * Completion callback of the richacl_queue_*() requests, called with the
+ * request's data argument.  For reads, @acl is the acl read, which the
+ * callback needs to free, and @st is the file status if RICHACL_QUEUE_STAT
+ * was requested and could be determined.  @error is 0 or an errno value.
+ * The callback may queue further requests.
+ */
+typedef void (*richacl_queue_done_t)(void *data, struct richacl *acl,
+				     const struct stat *st, int error);
+
+/* richacl_queue_alloc() flags */
+#define RICHACL_QUEUE_SYNC	0x1	/* do not use io_uring */
+
+/* richacl_queue_get_*() flags */
+#define RICHACL_QUEUE_STAT	0x1	/* determine the file status as well */
+
+struct richacl_queue;
+extern struct richacl_queue *richacl_queue_alloc(unsigned int, const char *,
+						 int, richacl_queue_done_t);
+extern void richacl_queue_free(struct richacl_queue *);
+extern int richacl_queue_get_file(struct richacl_queue *, const char *, int,
+				  void *);
+extern int richacl_queue_get_fd(struct richacl_queue *, int, int, void *);
+extern int richacl_queue_set_file(struct richacl_queue *, const char *,
+				  const struct richacl *, void *);
+extern int richacl_queue_set_fd(struct richacl_queue *, int,
+				const struct richacl *, void *);
+extern int richacl_queue_wait(struct richacl_queue *);
+
+struct richacl_pool;
+extern struct richacl_pool *richacl_pool_alloc(unsigned int);
+extern void richacl_pool_free(struct richacl_pool *);
+extern int richacl_bulk_get(struct richacl_pool *, unsigned int, const int *,
+			    const char *const *, int, struct richacl **,
+			    int *);
+extern int richacl_bulk_set(struct richacl_pool *, unsigned int, const int *,
+			    const char *const *, int,
+			    const struct richacl *const *, int *);
+extern int richacl_bulk_set_xattr(struct richacl_pool *, unsigned int,
+				  const int *, const char *const *, int,
+				  const void *, size_t, int *);
+extern int richacl_bulk_access(struct richacl_pool *, unsigned int,
+			       const int *, const char *const *, int,
+			       const struct richacl_cred *, int *, int *);
 
 extern char *richacl_mask_to_text(unsigned int, int);
 
@@ -156,9 +379,24 @@ extern struct richacl *richacl_inherit_inode(const struct richacl *, mode_t *,
 
 extern size_t richacl_xattr_size(const struct richacl *acl);
 extern struct richacl *richacl_from_xattr(const void *value, size_t size);
+extern size_t richacl_xattr_decoded_size(const void *, size_t);
+extern struct richacl *richacl_from_xattr_buffer(const void *, size_t, void *,
+						 size_t);
 extern void richacl_to_xattr(const struct richacl *acl, void *buffer);
 extern int richacl_valid(struct richacl *);
 
+extern int richacl_xattr_view_init(struct richacl_xattr_view *, const void *,
+				   size_t);
+extern void richacl_xattr_view_entry(const struct richacl_xattr_view *,
+				     unsigned int, struct richace *);
+extern bool richacl_xattr_view_permission(const struct richacl_xattr_view *,
+					  uid_t, gid_t,
+					  const struct richacl_cred *,
+					  unsigned int);
+extern int richacl_xattr_view_access(const struct richacl_xattr_view *,
+				     const struct stat *,
+				     const struct richacl_cred *);
+
 #ifdef __cplusplus
 }
 #endif  /* C++ */
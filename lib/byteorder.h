@@ -27,3 +27,29 @@
 #define cpu_to_le16 __cpu_to_le16
 #define le32_to_cpu __le32_to_cpu
 #define le16_to_cpu __le16_to_cpu
+
+/*
+ * The xattr format is little endian, and the fixed-size part of each entry
+ * has the same layout as the first part of struct richace, so on
+ * little-endian hosts entries can be copied without converting the fields
+ * one by one.  Defining RICHACL_FORCE_BYTESWAP (configure
+ * --enable-forced-byteswap) selects the code for big-endian hosts
+ * everywhere, for testing.
+ */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && !defined(RICHACL_FORCE_BYTESWAP)
+#define RICHACL_XATTR_NATIVE 1
+#endif
+
+#ifdef RICHACL_XATTR_NATIVE
+#define xattr_le16_to_cpu(x) le16_to_cpu(x)
+#define xattr_le32_to_cpu(x) le32_to_cpu(x)
+#else
+/* Byte by byte, independent of the host byte order. */
+#define xattr_le16_to_cpu(x) ({						\
+	const unsigned char *__p = (const unsigned char *)&(x);		\
+	(unsigned short)(__p[0] | __p[1] << 8); })
+#define xattr_le32_to_cpu(x) ({						\
+	const unsigned char *__p = (const unsigned char *)&(x);		\
+	(unsigned int)__p[0] | (unsigned int)__p[1] << 8 |		\
+	(unsigned int)__p[2] << 16 | (unsigned int)__p[3] << 24; })
+#endif
@@ -30,3 +30,32 @@ int in_groups(gid_t group, const gid_t groups[], int n_groups)
 			return 1;
 	return 0;
 }
+
+/**
+ * richacl_cred_in_group  -  check if a process is in a group
+ */
+int richacl_cred_in_group(const struct richacl_cred *cred, gid_t group)
+{
+	if (cred->cr_bitmap) {
+		gid_t n = group - cred->cr_bitmap_base;
+
+		return n < cred->cr_bitmap_bits &&
+		       (cred->cr_bitmap[n / 8] & (1 << (n % 8)));
+	}
+	if (cred->cr_sorted) {
+		int lo = 0, hi = cred->cr_n_groups;
+
+		while (lo < hi) {
+			int mid = lo + (hi - lo) / 2;
+
+			if (cred->cr_groups[mid] == group)
+				return 1;
+			if (cred->cr_groups[mid] < group)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return 0;
+	}
+	return in_groups(group, cred->cr_groups, cred->cr_n_groups);
+}
@@ -21,6 +21,9 @@
 #ifndef __RICHACL_INTERNAL_H
 #define __RICHACL_INTERNAL_H
 
+#include <stdint.h>
+#include <pthread.h>
+
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 #define ALIGN(x,a) (((x)+(a)-1)&~((a)-1))
 
@@ -38,6 +41,513 @@ struct richacl_alloc {
 	unsigned int count;
 };
 
+/**
+ * struct richacl_compiled_entry  -  decisive part of an acl entry
+ * @ce_pos:	position of the entry in the original acl
+ * @ce_mask:	mask flags decided by this entry
+ * @ce_deny:	whether the flags in @ce_mask are denied or allowed
+ *
+ * Only the mask flags which are not already decided by an earlier entry
+ * for the same principal are included in @ce_mask.
+ */
+struct richacl_compiled_entry {
+	unsigned int ce_pos;
+	unsigned int ce_mask;
+	unsigned int ce_deny;
+};
+
+/**
+ * struct richacl_compiled_who  -  entries of a single principal
+ * @cw_id:	user or group id (unused for owner@, group@, and everyone@)
+ * @cw_first:	index of the first entry in c_entries
+ * @cw_count:	number of entries
+ */
+struct richacl_compiled_who {
+	id_t cw_id;
+	unsigned int cw_first;
+	unsigned int cw_count;
+};
+
+/**
+ * struct richacl_compiled  -  acl prepared for permission checking
+ * @c_flat_allowed:	permissions allowed through owner@, group@, and
+ *			everyone@ alone, indexed by RICHACL_FLAT_OWNER and
+ *			RICHACL_FLAT_GROUP
+ * @c_flat_denied:	permissions denied in the same way
+ * @c_users:		user entries, sorted by uid
+ * @c_groups:		group entries, sorted by gid
+ *
+ * The group file mask has already been applied to the entries of masked
+ * acls where richacl_permission() would apply it.
+ */
+struct richacl_compiled {
+	unsigned char c_flags;
+	unsigned int c_owner_mask;
+	unsigned int c_group_mask;
+	unsigned int c_other_mask;
+	struct richacl_compiled_who c_owner;
+	struct richacl_compiled_who c_group;
+	struct richacl_compiled_who c_everyone;
+	unsigned int c_flat_allowed[4];
+	unsigned int c_flat_denied[4];
+	unsigned int c_n_users;
+	unsigned int c_n_groups;
+	struct richacl_compiled_who *c_users;
+	struct richacl_compiled_who *c_groups;
+	struct richacl_compiled_entry c_entries[0];
+};
+
+#define RICHACL_FLAT_OWNER 1
+#define RICHACL_FLAT_GROUP 2
+
+/**
+ * struct richacl_decision  -  permissions decided so far
+ * @d_pos:	position of the deciding entry for each mask flag
+ * @d_decided:	mask flags decided so far
+ * @d_denied:	mask flags denied so far
+ */
+struct richacl_decision {
+	unsigned int d_pos[32];
+	unsigned int d_decided;
+	unsigned int d_denied;
+};
+
+/**
+ * struct richacl_cred  -  user and groups of a process
+ * @cr_uid:	user id
+ * @cr_groups:	group ids
+ * @cr_n_groups: number of entries in @cr_groups
+ * @cr_sorted:	@cr_groups is sorted and contains no duplicates
+ * @cr_bitmap:	bitmap of the group ids in the range [@cr_bitmap_base,
+ *		@cr_bitmap_base + @cr_bitmap_bits), or NULL
+ * @cr_serial:	number identifying these credentials, or 0
+ *
+ * Credentials from richacl_cred_alloc() are sorted, and indexed by a
+ * bitmap when that is reasonably compact.  The functions which accept a
+ * plain array of groups wrap that array in an unsorted struct richacl_cred
+ * on the stack.  Credentials cannot change once allocated, so the decision
+ * cache uses @cr_serial to identify them; credentials on the stack have no
+ * serial number and are not cached.
+ */
+struct richacl_cred {
+	uid_t cr_uid;
+	int cr_n_groups;
+	const gid_t *cr_groups;
+	int cr_sorted;
+	gid_t cr_bitmap_base;
+	unsigned int cr_bitmap_bits;
+	const unsigned char *cr_bitmap;
+	unsigned long long cr_serial;
+};
+
+/**
+ * struct richacl_cache_key  -  what a cached decision depends on
+ * @k_hash:	content hash of the acl
+ * @k_cred:	serial number of the credentials
+ * @k_owner:	owner of the file
+ * @k_owning_group: owning group of the file
+ * @k_kind:	RICHACL_CACHE_PERMISSION or RICHACL_CACHE_ACCESS_*
+ * @k_mask:	requested permissions (RICHACL_CACHE_PERMISSION only)
+ */
+struct richacl_cache_key {
+	uint64_t k_hash;
+	unsigned long long k_cred;
+	uid_t k_owner;
+	gid_t k_owning_group;
+	unsigned int k_kind;
+	unsigned int k_mask;
+};
+
+#define RICHACL_CACHE_PERMISSION	0
+#define RICHACL_CACHE_ACCESS_FILE	1
+#define RICHACL_CACHE_ACCESS_DIR	2
+
+/**
+ * struct richacl_cache_entry  -  cached decision
+ * @ce_key:	what the decision depends on
+ * @ce_acl:	copy of the acl, to rule out hash collisions
+ * @ce_size:	number of entries allocated in @ce_acl
+ * @ce_granted:	permissions granted
+ * @ce_used:	when the entry was last used, for replacement
+ *
+ * An entry with a NULL @ce_acl is unused.
+ */
+struct richacl_cache_entry {
+	struct richacl_cache_key ce_key;
+	struct richacl *ce_acl;
+	unsigned int ce_size;
+	unsigned int ce_granted;
+	unsigned long ce_used;
+};
+
+#define RICHACL_CACHE_WAYS 4
+
+/**
+ * struct richacl_cache  -  bounded cache of access decisions
+ * @c_lock:	protects everything below
+ * @c_n_sets:	number of sets of RICHACL_CACHE_WAYS entries
+ * @c_clock:	incremented for each lookup
+ * @c_hits:	number of lookups which found a decision
+ * @c_misses:	number of lookups which did not
+ */
+struct richacl_cache {
+	pthread_mutex_t c_lock;
+	unsigned int c_n_sets;
+	unsigned long c_clock;
+	unsigned long c_hits;
+	unsigned long c_misses;
+	struct richacl_cache_entry c_entries[0];
+};
+
+/**
+ * struct richacl_masks_cache_entry  -  remembered richacl_apply_masks() result
+ * @me_hash:	richacl_hash() of @me_acl
+ * @me_owner:	owner the masks were applied for
+ * @me_acl:	shared copy of the acl, to rule out hash collisions
+ * @me_result:	shared result
+ * @me_used:	when the entry was last used, for replacement
+ *
+ * An entry with a NULL @me_acl is unused.
+ */
+struct richacl_masks_cache_entry {
+	uint64_t me_hash;
+	uid_t me_owner;
+	const struct richacl *me_acl;
+	const struct richacl *me_result;
+	unsigned long me_used;
+};
+
+/**
+ * struct richacl_masks_cache  -  bounded cache of richacl_apply_masks() results
+ * @mc_lock:	protects everything below
+ * @mc_store:	store holding the acls and results
+ * @mc_n_sets:	number of sets of RICHACL_CACHE_WAYS entries
+ * @mc_clock:	incremented for each lookup
+ * @mc_hits:	number of lookups which found a result
+ * @mc_misses:	number of lookups which did not
+ */
+struct richacl_masks_cache {
+	pthread_mutex_t mc_lock;
+	struct richacl_store *mc_store;
+	unsigned int mc_n_sets;
+	unsigned long mc_clock;
+	unsigned long mc_hits;
+	unsigned long mc_misses;
+	struct richacl_masks_cache_entry mc_entries[0];
+};
+
+/**
+ * struct richacl_propagated  -  acl after propagating the everyone@ permissions
+ * @p_acl:	the acl after richacl_propagate_everyone(), or NULL
+ * @p_owner_allow: permissions propagated to owner@
+ * @p_group_allow: permissions propagated to the group class
+ * @p_other_allow: permissions the trailing everyone@ entry keeps, if
+ *		@p_group_allow is not 0
+ * @p_used:	when the entry was last used, for replacement
+ *
+ * richacl_propagate_everyone() only depends on the masks through
+ * @p_owner_allow, @p_group_allow, and @p_other_allow, so @p_acl can be
+ * reused for all masks for which those are the same.
+ */
+struct richacl_propagated {
+	struct richacl *p_acl;
+	unsigned int p_owner_allow;
+	unsigned int p_group_allow;
+	unsigned int p_other_allow;
+	unsigned long p_used;
+};
+
+#define RICHACL_REMASK_PROPAGATED 4
+
+/**
+ * struct richacl_remask  -  acl prepared for applying different masks
+ * @r_owner:	file owner
+ * @r_normalized: the acl after richacl_move_everyone_aces_down(), which
+ *		does not depend on the masks
+ * @r_clock:	incremented for each richacl_remask()
+ * @r_propagated: @r_normalized after richacl_propagate_everyone() for the
+ *		masks of recent richacl_remask() calls
+ */
+struct richacl_remask {
+	uid_t r_owner;
+	struct richacl *r_normalized;
+	unsigned long r_clock;
+	struct richacl_propagated r_propagated[RICHACL_REMASK_PROPAGATED];
+};
+
+/**
+ * struct richacl_builder  -  acl under construction
+ * @b_alloc:	acl and number of allocated entries
+ *
+ * The allocation grows geometrically (see richacl_reserve()), and the bulk
+ * operations move each existing entry at most once, so building or
+ * editing an acl of n entries with k changes takes O(n + k) time.
+ */
+struct richacl_builder {
+	struct richacl_alloc b_alloc;
+};
+
+/**
+ * struct richacl_interned  -  acl in a store
+ * @i_store:	store the acl is in
+ * @i_next:	next acl in the same hash bucket
+ * @i_hash:	richacl_hash() of the acl
+ * @i_refcount:	number of references to the acl
+ *
+ * The acl follows this structure, and its unmapped identifiers follow the
+ * acl, all in one allocation; richacl_intern_put() frees it as a whole.
+ */
+struct richacl_interned {
+	struct richacl_store *i_store;
+	struct richacl_interned *i_next;
+	uint64_t i_hash;
+	unsigned int i_refcount;
+};
+
+static inline struct richacl *richacl_interned_acl(struct richacl_interned *i)
+{
+	return (struct richacl *)(i + 1);
+}
+
+static inline struct richacl_interned *
+richacl_acl_interned(const struct richacl *acl)
+{
+	return (struct richacl_interned *)acl - 1;
+}
+
+#define RICHACL_STORE_SHARDS 16
+
+/**
+ * struct richacl_store_shard  -  part of a store
+ * @ss_lock:	protects everything below, and the reference counts of the
+ *		acls in this shard dropping to zero
+ * @ss_buckets:	hash table of the acls
+ * @ss_n_buckets: size of @ss_buckets, a power of two
+ * @ss_count:	number of acls in this shard
+ */
+struct richacl_store_shard {
+	pthread_mutex_t ss_lock;
+	struct richacl_interned **ss_buckets;
+	unsigned int ss_n_buckets;
+	unsigned int ss_count;
+} __attribute__((aligned(64)));
+
+/**
+ * struct richacl_store  -  set of shared, immutable acls
+ * @s_hits:	number of richacl_intern() calls which found the acl
+ * @s_misses:	number of richacl_intern() calls which added the acl
+ * @s_shards:	the acls, spread over independently locked shards by hash
+ */
+struct richacl_store {
+	unsigned long s_hits;
+	unsigned long s_misses;
+	struct richacl_store_shard s_shards[RICHACL_STORE_SHARDS];
+};
+
+static inline struct richacl_store_shard *
+richacl_store_shard(struct richacl_store *store, uint64_t hash)
+{
+	return &store->s_shards[(hash >> 32) % RICHACL_STORE_SHARDS];
+}
+
+/**
+ * struct richacl_packed  -  acl with the entry fields in separate arrays
+ * @p_masks:	e_mask of each entry
+ * @p_ids:	e_id of each entry; for entries with an unmapped identifier,
+ *		the offset of the identifier in @p_who
+ * @p_ace_flags: e_flags of each entry
+ * @p_types:	e_type of each entry
+ * @p_classes:	richace_class() of each entry, with RICHACL_PACKED_INHERIT_ONLY
+ *		set for inherit-only entries
+ * @p_who:	pool of the unmapped identifiers, each null terminated
+ * @p_who_size: size of @p_who
+ *
+ * Checking permissions only needs to scan @p_classes, plus @p_ids for user
+ * and group entries; the other arrays are only looked at for the entries
+ * which match.  Everything is allocated together with the structure.
+ */
+struct richacl_packed {
+	unsigned char p_flags;
+	unsigned short p_count;
+	unsigned int p_owner_mask;
+	unsigned int p_group_mask;
+	unsigned int p_other_mask;
+	unsigned int *p_masks;
+	id_t *p_ids;
+	unsigned short *p_ace_flags;
+	unsigned short *p_types;
+	unsigned char *p_classes;
+	char *p_who;
+	size_t p_who_size;
+};
+
+#define RICHACL_PACKED_INHERIT_ONLY 0x80
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static inline uint64_t richacl_hash_u32(uint64_t hash, uint32_t value)
+{
+	int n;
+
+	for (n = 0; n < 4; n++) {
+		hash ^= (value >> (n * 8)) & 0xff;
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+/*
+ * The content hash is computed the same way for all representations of an
+ * acl (see richacl_hash()).  Unmapped identifiers are hashed as strings,
+ * without the terminating null.
+ */
+static inline uint64_t richacl_hash_header(unsigned int flags,
+					   unsigned int count,
+					   unsigned int owner_mask,
+					   unsigned int group_mask,
+					   unsigned int other_mask)
+{
+	uint64_t hash = FNV_OFFSET_BASIS;
+
+	hash = richacl_hash_u32(hash, flags);
+	hash = richacl_hash_u32(hash, count);
+	hash = richacl_hash_u32(hash, owner_mask);
+	hash = richacl_hash_u32(hash, group_mask);
+	return richacl_hash_u32(hash, other_mask);
+}
+
+static inline uint64_t richacl_hash_entry(uint64_t hash, unsigned int type,
+					  unsigned int flags,
+					  unsigned int mask, id_t id,
+					  const char *who)
+{
+	hash = richacl_hash_u32(hash, type | (flags << 16));
+	hash = richacl_hash_u32(hash, mask);
+	if (flags & RICHACE_UNMAPPED_WHO) {
+		for (; *who; who++) {
+			hash ^= (unsigned char)*who;
+			hash *= FNV_PRIME;
+		}
+	} else
+		hash = richacl_hash_u32(hash, id);
+	return hash;
+}
+
+/*
+ * Hash of the identifier of an entry, for entries which
+ * richace_is_same_identifier() considers equal.  This is only used for
+ * hash tables, so mapped identifiers use a cheaper multiplicative hash.
+ */
+static inline uint64_t richace_identifier_hash(const struct richace *ace)
+{
+	uint64_t hash = ace->e_flags & (RICHACE_SPECIAL_WHO |
+					RICHACE_IDENTIFIER_GROUP |
+					RICHACE_UNMAPPED_WHO);
+
+	if (hash & RICHACE_UNMAPPED_WHO)
+		return richacl_hash_entry(FNV_OFFSET_BASIS, 0, hash, 0, 0,
+					  ace->e_who);
+	hash = (hash << 32 | ace->e_id) * 0x9e3779b97f4a7c15ULL;
+	return hash >> 32;
+}
+
+struct richacl_queue_slot;
+struct richacl_queue_ring;
+
+/**
+ * struct richacl_queue  -  queue of acl reads and writes
+ * @q_name:	name of the xattr to read and write
+ * @q_done:	completion callback
+ * @q_depth:	maximum number of requests in flight
+ * @q_slots:	state of each request
+ * @q_buffers:	@q_depth value buffers of RICHACL_ACCESS_BUFFER_SIZE bytes
+ * @q_free:	stack of unused slot numbers
+ * @q_n_free:	number of slot numbers on @q_free
+ * @q_ring:	io_uring instance, or NULL for synchronous operation
+ */
+struct richacl_queue {
+	char *q_name;
+	richacl_queue_done_t q_done;
+	unsigned int q_depth;
+	struct richacl_queue_slot *q_slots;
+	void *q_buffers;
+	unsigned int *q_free;
+	unsigned int q_n_free;
+	struct richacl_queue_ring *q_ring;
+};
+
+#define RICHACL_QUEUE_GET	0
+#define RICHACL_QUEUE_SET	1
+
+extern int richacl_queue_setup(struct richacl_queue *, unsigned int, bool);
+extern int richacl_queue_push(struct richacl_queue *, int, const char *, int,
+			      const struct richacl *, int, void *);
+extern int richacl_queue_drain(struct richacl_queue *);
+extern void richacl_queue_teardown(struct richacl_queue *);
+
+/**
+ * struct richacl_pool_range  -  range of items assigned to a worker
+ * @pr_next:	next item to process; advanced by the worker and by thieves
+ * @pr_end:	end of the range
+ *
+ * Each worker works through its own range first, and then steals items
+ * from the ranges of the other workers.  Items are taken from the front
+ * with an atomic increment in either case.
+ */
+struct richacl_pool_range {
+	unsigned int pr_next;
+	unsigned int pr_end;
+} __attribute__((aligned(64)));
+
+/**
+ * struct richacl_pool_thread  -  worker thread
+ * @pt_pool:	pool the thread belongs to
+ * @pt_index:	number of the range the thread works on first
+ * @pt_thread:	thread id
+ */
+struct richacl_pool_thread {
+	struct richacl_pool *pt_pool;
+	unsigned int pt_index;
+	pthread_t pt_thread;
+};
+
+/**
+ * struct richacl_pool  -  pool of worker threads for the bulk functions
+ * @p_run_lock:	serializes richacl_pool_run()
+ * @p_lock:	protects the fields below
+ * @p_work:	signaled when a job is posted or the pool is shut down
+ * @p_idle:	signaled when a thread has finished the current job
+ * @p_workers:	number of workers, including the thread calling
+ *		richacl_pool_run()
+ * @p_threads:	the @p_workers - 1 other threads
+ * @p_generation: incremented for each job
+ * @p_busy:	number of threads still working on the current job
+ * @p_stop:	shut down the threads
+ * @p_fn:	function to call for each item of the current job
+ * @p_arg:	first argument of @p_fn
+ * @p_ranges:	items assigned to each worker
+ */
+struct richacl_pool {
+	pthread_mutex_t p_run_lock;
+	pthread_mutex_t p_lock;
+	pthread_cond_t p_work;
+	pthread_cond_t p_idle;
+	unsigned int p_workers;
+	struct richacl_pool_thread *p_threads;
+	unsigned long p_generation;
+	unsigned int p_busy;
+	bool p_stop;
+	void (*p_fn)(void *, unsigned int);
+	void *p_arg;
+	struct richacl_pool_range *p_ranges;
+};
+
+extern int richacl_pool_start(struct richacl_pool *);
+extern void richacl_pool_stop(struct richacl_pool *);
+extern void richacl_pool_run(struct richacl_pool *, unsigned int,
+			     void (*)(void *, unsigned int), void *);
+
 extern const char *richace_owner_who;
 extern const char *richace_group_who;
 extern const char *richace_everyone_who;
@@ -45,12 +555,273 @@ extern const char *richace_everyone_who;
 extern void richace_free(struct richace *);
 extern unsigned int richacl_mode_to_mask(mode_t);
 extern int in_groups(gid_t, const gid_t[], int);
+extern int richacl_cred_in_group(const struct richacl_cred *, gid_t);
 extern int richacl_mask_to_mode(unsigned int);
 
+extern int richacl_reserve(struct richacl_alloc *, unsigned int);
+extern int richacl_identifiers(const struct richacl *, unsigned int *);
 extern void richacl_delete_entry(struct richacl_alloc *, struct richace **);
 extern int richacl_insert_entry(struct richacl_alloc *, struct richace **);
 extern struct richace *richacl_append_entry(struct richacl_alloc *);
 extern int richace_change_mask(struct richacl_alloc *, struct richace **, unsigned int);
+extern int richacl_move_everyone_aces_down(struct richacl_alloc *);
+extern int richacl_propagate_everyone(struct richacl_alloc *);
+extern int richacl_apply_masks_normalized(struct richacl_alloc *, uid_t);
+
+extern int richacl_xattr_count(const void *, size_t);
+extern int richacl_xattr_decode(struct richacl *, const void *, size_t);
+struct richace_xattr;
+extern int richacl_xattr_decode_entries(struct richace *,
+					const struct richace_xattr *,
+					unsigned int);
+extern unsigned int richacl_xattr_encode_entries(struct richace_xattr *,
+						 const struct richace *,
+						 unsigned int);
+extern struct richacl *richacl_from_xattr_behind(void *, size_t, size_t);
+extern ssize_t richacl_getxattr_at(int, const char *, int, void *, size_t);
+extern int richacl_setxattr_at(int, const char *, int, const void *, size_t);
+
+struct stat;
+extern int richacl_access_acl(const struct richacl *, const struct stat *,
+			      const struct richacl_cred *);
+extern int richacl_access_acl_cache(struct richacl_cache *,
+				    const struct richacl *,
+				    const struct stat *,
+				    const struct richacl_cred *);
+extern int richacl_access_buffer_cache(const char *, const struct stat *,
+				       const struct richacl_cred *,
+				       void *, size_t,
+				       struct richacl_cache *);
+
+extern bool richacl_cache_key(struct richacl_cache_key *,
+			      const struct richacl *, uid_t, gid_t,
+			      const struct richacl_cred *,
+			      unsigned int, unsigned int);
+extern bool richacl_cache_lookup(struct richacl_cache *,
+				 const struct richacl_cache_key *,
+				 const struct richacl *, unsigned int *);
+extern void richacl_cache_insert(struct richacl_cache *,
+				 const struct richacl_cache_key *,
+				 const struct richacl *, unsigned int);
+
+extern const struct richacl_compiled_who *
+richacl_compiled_lookup(const struct richacl_compiled_who *, unsigned int, id_t);
+extern void richacl_compiled_decide(const struct richacl_compiled *,
+				    const struct richacl_compiled_who *,
+				    unsigned int, struct richacl_decision *);
+
+/**
+ * struct richacl_eval  -  state of evaluating an acl for a process
+ * @ev_flags:	acl flags (RICHACL_MASKED and RICHACL_WRITE_THROUGH matter)
+ * @ev_owner_mask: owner file mask of the acl
+ * @ev_group_mask: group file mask of the acl
+ * @ev_other_mask: other file mask of the acl
+ * @ev_is_owner: the process owns the file
+ * @ev_in_owner_or_group_class: the process is in the owner or group file
+ *		class, or the acl is not masked
+ * @ev_undecided: mask flags no matching entry has decided yet
+ * @ev_allowed:	mask flags decided by matching allow entries
+ * @ev_denied:	mask flags decided by matching deny entries
+ * @ev_required: mask flags which must all be granted
+ *
+ * This is the algorithm of richacl_permission_cred() and
+ * richacl_access_acl(), independent of how the acl is represented: an
+ * evaluator calls richacl_eval_init(), then richacl_eval_entry() for each
+ * entry that applies to the process, in order, and finally
+ * richacl_eval_granted() or richacl_eval_mask() for the result.
+ */
+struct richacl_eval {
+	unsigned int ev_flags;
+	unsigned int ev_owner_mask;
+	unsigned int ev_group_mask;
+	unsigned int ev_other_mask;
+	bool ev_is_owner;
+	bool ev_in_owner_or_group_class;
+	unsigned int ev_undecided;
+	unsigned int ev_allowed;
+	unsigned int ev_denied;
+	unsigned int ev_required;
+};
+
+/*
+ * Start evaluating an acl with flags @flags and the given file masks.  To
+ * check for @mask, pass @mask as @required; to determine all the flags the
+ * process is granted, pass RICHACE_VALID_MASK as @mask and 0 as @required.
+ *
+ * Returns true when the result does not depend on the entries.
+ */
+static inline bool
+richacl_eval_init(struct richacl_eval *ev, unsigned int flags,
+		  unsigned int owner_mask, unsigned int group_mask,
+		  unsigned int other_mask, bool is_owner, bool in_owning_group,
+		  unsigned int mask, unsigned int required)
+{
+	ev->ev_flags = flags;
+	ev->ev_owner_mask = owner_mask;
+	ev->ev_group_mask = group_mask;
+	ev->ev_other_mask = other_mask;
+	ev->ev_is_owner = is_owner;
+
+	/*
+	 * A process is
+	 *   - in the owner file class if it owns the file,
+	 *   - in the group file class if it is in the file's owning group or
+	 *     it matches any of the user or group entries, and
+	 *   - in the other file class otherwise.
+	 * The file class is only relevant for determining which file mask to
+	 * apply, which only happens for masked acls.
+	 */
+	ev->ev_in_owner_or_group_class = in_owning_group ||
+					 !(flags & RICHACL_MASKED);
+	ev->ev_undecided = mask;
+	ev->ev_allowed = 0;
+	ev->ev_denied = 0;
+	ev->ev_required = required;
+	return (flags & RICHACL_MASKED) && (flags & RICHACL_WRITE_THROUGH) &&
+	       is_owner;
+}
+
+/*
+ * The mask flags an entry of class @class (see richace_class()), type
+ * @type, and mask @ace_mask which applies to the process can decide.
+ */
+static inline unsigned int
+richacl_eval_ace_mask(const struct richacl_eval *ev, unsigned int class,
+		      unsigned int type, unsigned int ace_mask)
+{
+	/*
+	 * Apply the group file mask to entries other than owner@ and
+	 * everyone@ or user entries matching the owner.  This ensures
+	 * that we grant the same permissions as the acl computed by
+	 * richacl_apply_masks().
+	 *
+	 * Without this restriction, the following richacl would grant
+	 * rw access to processes which are both the owner and in the
+	 * owning group, but not to other users in the owning group,
+	 * which could not be represented without masks:
+	 *
+	 *  owner:rw::mask
+	 *  group@:rw::allow
+	 */
+	if ((ev->ev_flags & RICHACL_MASKED) &&
+	    type == RICHACE_ACCESS_ALLOWED_ACE_TYPE &&
+	    (class == RICHACE_CLASS_GROUP || class == RICHACE_CLASS_GID))
+		ace_mask &= ev->ev_group_mask;
+	return ace_mask;
+}
+
+/*
+ * Apply the next entry which applies to the process.  Returns true when
+ * the remaining entries cannot change the result.
+ */
+static inline bool
+richacl_eval_entry(struct richacl_eval *ev, unsigned int class,
+		   unsigned int type, unsigned int ace_mask)
+{
+	ace_mask = richacl_eval_ace_mask(ev, class, type, ace_mask);
+	if (class != RICHACE_CLASS_EVERYONE)
+		ev->ev_in_owner_or_group_class = true;
+	if (type == RICHACE_ACCESS_ALLOWED_ACE_TYPE)
+		ev->ev_allowed |= ace_mask & ev->ev_undecided;
+	else if (type == RICHACE_ACCESS_DENIED_ACE_TYPE)
+		ev->ev_denied |= ace_mask & ev->ev_undecided;
+	ev->ev_undecided &= ~ace_mask;
+
+	/*
+	 * Keep going until we know which file class the process is in.
+	 */
+	return (ev->ev_denied & ev->ev_required) ||
+	       (!ev->ev_undecided && ev->ev_in_owner_or_group_class);
+}
+
+/* The mask flags granted, limited by the file mask of the file class. */
+static inline unsigned int richacl_eval_mask(const struct richacl_eval *ev)
+{
+	if (!(ev->ev_flags & RICHACL_MASKED))
+		return ev->ev_allowed;
+	if (ev->ev_is_owner) {
+		if (ev->ev_flags & RICHACL_WRITE_THROUGH)
+			return ev->ev_owner_mask;
+		return ev->ev_allowed & ev->ev_owner_mask;
+	}
+	if (ev->ev_in_owner_or_group_class)
+		return ev->ev_allowed & ev->ev_group_mask;
+	if (ev->ev_flags & RICHACL_WRITE_THROUGH)
+		return ev->ev_other_mask;
+	return ev->ev_allowed & ev->ev_other_mask;
+}
+
+/*
+ * Whether all the @required flags passed to richacl_eval_init() are
+ * granted.  A flag is granted unless a deny entry decides it or no entry
+ * decides it, and the file mask of the file class must include it.  Unlike
+ * in richacl_eval_mask(), deny entries also count for the write-through
+ * other mask.
+ */
+static inline bool richacl_eval_granted(const struct richacl_eval *ev)
+{
+	unsigned int required = ev->ev_required;
+
+	if (!(ev->ev_flags & RICHACL_MASKED))
+		return !(required & (ev->ev_denied | ev->ev_undecided));
+	if (ev->ev_is_owner && (ev->ev_flags & RICHACL_WRITE_THROUGH))
+		return !(required & ~ev->ev_owner_mask);
+	if (required & ev->ev_denied)
+		return false;
+
+	/*
+	 * The file class a process is in determines which file mask
+	 * applies.  Check if that file mask also grants the requested
+	 * access.
+	 */
+	if (ev->ev_is_owner) {
+		if (required & ~ev->ev_owner_mask)
+			return false;
+	} else if (ev->ev_in_owner_or_group_class) {
+		if (required & ~ev->ev_group_mask)
+			return false;
+	} else {
+		if (ev->ev_flags & RICHACL_WRITE_THROUGH)
+			return !(required & ~ev->ev_other_mask);
+		if (required & ~ev->ev_other_mask)
+			return false;
+	}
+	return !(required & ev->ev_undecided);
+}
+
+/*
+ * The richace_class() of @ace if it applies to the process with credentials
+ * @cred, and RICHACE_CLASS_INVALID otherwise.
+ */
+static inline unsigned int
+richacl_eval_match(const struct richace *ace, uid_t owner,
+		   bool in_owning_group, const struct richacl_cred *cred)
+{
+	unsigned int class = richace_class(ace);
+
+	if (richace_is_inherit_only(ace))
+		return RICHACE_CLASS_INVALID;
+	switch (class) {
+	case RICHACE_CLASS_OWNER:
+		return cred->cr_uid == owner ? class : RICHACE_CLASS_INVALID;
+	case RICHACE_CLASS_GROUP:
+		return in_owning_group ? class : RICHACE_CLASS_INVALID;
+	case RICHACE_CLASS_UID:
+		return cred->cr_uid == ace->e_id ? class :
+						   RICHACE_CLASS_INVALID;
+	case RICHACE_CLASS_GID:
+		return richacl_cred_in_group(cred, ace->e_id) ? class :
+			RICHACE_CLASS_INVALID;
+	case RICHACE_CLASS_EVERYONE:
+		return class;
+	default:
+		return RICHACE_CLASS_INVALID;
+	}
+}
+
+extern void richacl_xattr_view_eval(const struct richacl_xattr_view *, uid_t,
+				    bool, const struct richacl_cred *,
+				    struct richacl_eval *);
 
 struct string_buffer;
 extern void write_mask(struct string_buffer *, unsigned int, int);
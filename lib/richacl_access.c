@@ -19,13 +19,18 @@
 */
 
 #include <sys/types.h>
-#include <sys/stat.h>
+#include <stddef.h>
 #include <unistd.h>
-#include <stdlib.h>
 #include <errno.h>
 #include "sys/richacl.h"
 #include "richacl-internal.h"
 
+/*
+ * Number of groups of the calling process which fit on the stack; processes
+ * in more groups fall back to richacl_cred_alloc().
+ */
+#define RICHACL_ACCESS_GROUPS	64
+
 /**
  * richacl_access  -  Determine the permissions of a "process"
  * @file:	file name
@@ -42,145 +47,32 @@
 int richacl_access(const char *file, const struct stat *st, uid_t user,
 		   const gid_t *groups, int n_groups)
 {
-	const struct richacl *acl;
-	const struct richace *ace;
-	struct stat local_st;
-	unsigned int mask = RICHACE_VALID_MASK, allowed = 0;
-	int in_owning_group;
-	int in_owner_or_group_class;
-	gid_t *groups_alloc = NULL;
-
-	if (!st) {
-		if (stat(file, &local_st) != 0)
-			return -1;
-		st = &local_st;
-	}
-
-	acl = richacl_get_file(file);
-	if (!acl) {
-		if (errno == ENODATA || errno == ENOTSUP || errno == ENOSYS) {
-			acl = richacl_from_mode(st->st_mode);
-			if (!acl)
-				return -1;
-		} else
-			return -1;
-	}
+	gid_t process_groups[RICHACL_ACCESS_GROUPS];
+	struct richacl_cred *cred, local_cred = {
+		.cr_uid = user,
+		.cr_groups = groups,
+		.cr_n_groups = n_groups,
+	};
+	int allowed;
 
 	if (n_groups < 0) {
-		n_groups = getgroups(0, NULL);
-		if (n_groups < 0)
-			return -1;
-		groups_alloc = malloc(sizeof(gid_t) * (n_groups + 1));
-		if (!groups_alloc)
+		process_groups[0] = getegid();
+		n_groups = getgroups(RICHACL_ACCESS_GROUPS - 1,
+				     process_groups + 1);
+		if (n_groups >= 0) {
+			local_cred.cr_groups = process_groups;
+			local_cred.cr_n_groups = n_groups + 1;
+		} else if (errno != EINVAL)
 			return -1;
-		groups_alloc[0] = getegid();
-		if (getgroups(n_groups, groups_alloc + 1) < 0) {
-			free(groups_alloc);
-			return -1;
-		}
-		groups = groups_alloc;
-	}
-
-	in_owning_group = in_groups(st->st_gid, groups, n_groups);
-	in_owner_or_group_class = in_owning_group;
-
-	/*
-	 * A process is
-	 *   - in the owner file class if it owns the file,
-	 *   - in the group file class if it is in the file's owning group or
-	 *     it matches any of the user or group entries, and
-	 *   - in the other file class otherwise.
-	 * The file class is only relevant for determining which file mask to
-	 * apply, which only happens for masked acls.
-	 */
-
-	if (acl->a_flags & RICHACL_MASKED) {
-		if ((acl->a_flags & RICHACL_WRITE_THROUGH) && user == st->st_uid)
-			return acl->a_owner_mask;
-	} else {
-		/*
-		 * We don't care which class the process is in when the
-		 * acl is not masked.
-		 */
-		in_owner_or_group_class = 1;
 	}
-
-	richacl_for_each_entry(ace, acl) {
-		unsigned int ace_mask = ace->e_mask;
-
-		if (richace_is_inherit_only(ace))
-			continue;
-		if (richace_is_owner(ace)) {
-			if (user != st->st_uid)
-				continue;
-			goto entry_matches_owner;
-		} else if (richace_is_group(ace)) {
-			if (!in_owning_group)
-				continue;
-		} else if (richace_is_unix_user(ace)) {
-			if (user != ace->e_id)
-				continue;
-			goto entry_matches_owner;
-		} else if (richace_is_unix_group(ace)) {
-			if (!in_groups(ace->e_id, groups, n_groups))
-				continue;
-		} else if (richace_is_everyone(ace))
-			goto entry_matches_everyone;
-		else
-			continue;
-
-		/*
-		 * Apply the group file mask to entries other than owner@ and
-		 * everyone@ or user entries matching the owner.  This ensures
-		 * that we grant the same permissions as the acl computed by
-		 * richacl_apply_masks().
-		 *
-		 * Without this restriction, the following richacl would grant
-		 * rw access to processes which are both the owner and in the
-		 * owning group, but not to other users in the owning group,
-		 * which could not be represented without masks:
-		 *
-		 *  owner:rw::mask
-		 *  group@:rw::allow
-		 */
-		if ((acl->a_flags & RICHACL_MASKED) && richace_is_allow(ace))
-			ace_mask &= acl->a_group_mask;
-
-entry_matches_owner:
-		/* The process is in the owner or group file class. */
-		in_owner_or_group_class = 1;
-
-entry_matches_everyone:
-		/* Check which mask flags the ACE allows or denies. */
-		if (richace_is_allow(ace))
-			allowed |= ace_mask & mask;
-		mask &= ~ace_mask;
-		if (!mask && in_owner_or_group_class)
-			break;
-	}
-
-	if (acl->a_flags & RICHACL_MASKED) {
-		/*
-		 * Figure out which file mask applies.
-		 */
-		if (user == st->st_uid)
-			allowed &= acl->a_owner_mask;
-		else if (in_owner_or_group_class)
-			allowed &= acl->a_group_mask;
-		else {
-			if (acl->a_flags & RICHACL_WRITE_THROUGH)
-				allowed = acl->a_other_mask;
-			else
-				allowed &= acl->a_other_mask;
-		}
-	}
-
-	/* RICHACE_DELETE_CHILD is meaningless for non-directories. */
-	if (!S_ISDIR(st->st_mode))
-		allowed &= ~RICHACE_DELETE_CHILD;
-
-	if (groups != groups_alloc)
-		free(groups_alloc);
-
+	if (local_cred.cr_n_groups >= 0)
+		return richacl_access_cred(file, st, &local_cred);
+
+	/* Too many groups for the stack. */
+	cred = richacl_cred_alloc(user, NULL, -1);
+	if (!cred)
+		return -1;
+	allowed = richacl_access_cred(file, st, cred);
+	richacl_cred_free(cred);
 	return allowed;
 }
@@ -0,0 +1,81 @@
+/*
+  Copyright (C) 2006, 2009, 2010  Novell, Inc.
+  Copyright (C) 2015  Red Hat, Inc.
+  Written by Andreas Gruenbacher <agruenba@redhat.com>
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/stat.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_access_acl  -  Determine the permissions of a process
+ * @acl:	acl of the file (or NULL)
+ * @st:		status of the file
+ * @cred:	user and groups to check permissions for
+ *
+ * Returns the permissions which @acl grants to a process with credentials
+ * @cred.  When @acl is NULL, the file permission bits in @st->st_mode
+ * determine the permissions; this is equivalent to using the acl
+ * richacl_from_mode() would return, without allocating that acl.
+ */
+int richacl_access_acl(const struct richacl *acl, const struct stat *st,
+		       const struct richacl_cred *cred)
+{
+	const struct richace *ace;
+	struct richacl_eval ev;
+	unsigned int allowed;
+	uid_t user = cred->cr_uid;
+	int in_owning_group;
+
+	in_owning_group = richacl_cred_in_group(cred, st->st_gid);
+
+	if (!acl) {
+		if (user == st->st_uid)
+			allowed = richacl_mode_to_mask(st->st_mode >> 6);
+		else if (in_owning_group)
+			allowed = richacl_mode_to_mask(st->st_mode >> 3);
+		else
+			allowed = richacl_mode_to_mask(st->st_mode);
+		goto out;
+	}
+
+	if (richacl_eval_init(&ev, acl->a_flags, acl->a_owner_mask,
+			      acl->a_group_mask, acl->a_other_mask,
+			      user == st->st_uid, in_owning_group,
+			      RICHACE_VALID_MASK, 0))
+		goto masked;
+	richacl_for_each_entry(ace, acl) {
+		unsigned int class;
+
+		class = richacl_eval_match(ace, st->st_uid, in_owning_group,
+					   cred);
+		if (class != RICHACE_CLASS_INVALID &&
+		    richacl_eval_entry(&ev, class, ace->e_type,
+				       ace->e_mask))
+			break;
+	}
+masked:
+	allowed = richacl_eval_mask(&ev);
+
+out:
+	/* RICHACE_DELETE_CHILD is meaningless for non-directories. */
+	if (!S_ISDIR(st->st_mode))
+		allowed &= ~RICHACE_DELETE_CHILD;
+
+	return allowed;
+}
@@ -0,0 +1,134 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <linux/xattr.h>
+#include <linux/richacl_xattr.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/* Upper bound for the size of the decoded acl of an xattr of @size bytes. */
+static size_t decoded_size(size_t size)
+{
+	return sizeof(struct richacl) + sizeof(void *) +
+	       size / sizeof(struct richace_xattr) * sizeof(struct richace);
+}
+
+/*
+ * Like richacl_access_buffer(), but look up and remember the result in
+ * @cache (if not NULL).
+ */
+int richacl_access_buffer_cache(const char *file, const struct stat *st,
+				const struct richacl_cred *cred,
+				void *buffer, size_t size,
+				struct richacl_cache *cache)
+{
+	struct stat local_st;
+	struct richacl *acl = NULL;
+	void *value = buffer, *heap = NULL;
+	ssize_t len;
+	int allowed = -1;
+
+	if (!st) {
+		if (stat(file, &local_st) != 0)
+			return -1;
+		st = &local_st;
+	}
+
+	len = getxattr(file, XATTR_NAME_RICHACL, value, size);
+	while (len < 0 && errno == ERANGE) {
+		len = getxattr(file, XATTR_NAME_RICHACL, NULL, 0);
+		if (len < 0)
+			return -1;
+		free(heap);
+		size = len + decoded_size(len);
+		heap = malloc(size);
+		if (!heap)
+			return -1;
+		value = heap;
+		len = getxattr(file, XATTR_NAME_RICHACL, value, size);
+	}
+	if (len < 0) {
+		if (errno != ENODATA && errno != ENOTSUP && errno != ENOSYS)
+			goto out;
+	} else if (!cache) {
+		struct richacl_xattr_view view;
+
+		/* Evaluate the xattr value as is. */
+		if (richacl_xattr_view_init(&view, value, len) == 0)
+			allowed = richacl_xattr_view_access(&view, st, cred);
+		goto out;
+	} else {
+		uintptr_t start = ALIGN((uintptr_t)value + len, sizeof(void *));
+		int count = richacl_xattr_count(value, len);
+
+		if (count < 0)
+			goto out;
+		if (start + sizeof(struct richacl) +
+		    count * sizeof(struct richace) <= (uintptr_t)value + size)
+			acl = (struct richacl *)start;
+		else {
+			heap = malloc(len + decoded_size(len));
+			if (!heap)
+				goto out;
+			value = memcpy(heap, value, len);
+			acl = (struct richacl *)ALIGN((uintptr_t)value + len,
+						      sizeof(void *));
+		}
+		if (richacl_xattr_decode(acl, value, len) < 0)
+			goto out;
+	}
+	if (acl && cache)
+		allowed = richacl_access_acl_cache(cache, acl, st, cred);
+	else
+		allowed = richacl_access_acl(acl, st, cred);
+
+out:
+	free(heap);
+	return allowed;
+}
+
+/**
+ * richacl_access_buffer  -  Determine the permissions of a process
+ * @file:	file name
+ * @st:		status of file @file (or NULL)
+ * @cred:	user and groups to check permissions for
+ * @buffer:	scratch buffer
+ * @size:	size of @buffer
+ *
+ * Like richacl_access_cred(), but reads the acl of @file into @buffer and
+ * evaluates it there without decoding it.  When @buffer is big enough for
+ * the xattr value, this takes a single getxattr() call, plus a stat() call
+ * when @st is NULL, and does not allocate any memory.  Acls which do not
+ * fit still work, but take an additional getxattr() call and a temporary
+ * allocation.
+ *
+ * Returns the permissions granted, or -1 with errno set on error.
+ */
+int richacl_access_buffer(const char *file, const struct stat *st,
+			  const struct richacl_cred *cred,
+			  void *buffer, size_t size)
+{
+	return richacl_access_buffer_cache(file, st, cred, buffer, size, NULL);
+}
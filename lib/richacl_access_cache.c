@@ -0,0 +1,65 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/stat.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/*
+ * Like richacl_access_acl(), but look up the result in @cache first, and
+ * remember it there otherwise.
+ */
+int richacl_access_acl_cache(struct richacl_cache *cache,
+			     const struct richacl *acl, const struct stat *st,
+			     const struct richacl_cred *cred)
+{
+	struct richacl_cache_key key;
+	unsigned int kind, granted;
+
+	kind = S_ISDIR(st->st_mode) ? RICHACL_CACHE_ACCESS_DIR :
+				      RICHACL_CACHE_ACCESS_FILE;
+	if (!richacl_cache_key(&key, acl, st->st_uid, st->st_gid, cred,
+			       kind, 0))
+		return richacl_access_acl(acl, st, cred);
+	if (richacl_cache_lookup(cache, &key, acl, &granted))
+		return granted;
+	granted = richacl_access_acl(acl, st, cred);
+	richacl_cache_insert(cache, &key, acl, granted);
+	return granted;
+}
+
+/**
+ * richacl_access_cache  -  Determine the permissions of a process
+ * @cache:	decision cache from richacl_cache_alloc()
+ * @file:	file name
+ * @st:		status of file @file (or NULL)
+ * @cred:	user and groups to check permissions for
+ *
+ * Like richacl_access_cred(), but looks up the permissions granted by the
+ * acl of @file in @cache first, and remembers them there otherwise.  The
+ * acl is still read from @file each time.
+ */
+int richacl_access_cache(struct richacl_cache *cache, const char *file,
+			 const struct stat *st,
+			 const struct richacl_cred *cred)
+{
+	unsigned long buffer[RICHACL_ACCESS_BUFFER_SIZE / sizeof(unsigned long)];
+
+	return richacl_access_buffer_cache(file, st, cred, buffer,
+					   sizeof(buffer), cache);
+}
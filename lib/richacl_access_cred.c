@@ -0,0 +1,40 @@
+/*
+  Copyright (C) 2006, 2009, 2010  Novell, Inc.
+  Copyright (C) 2015  Red Hat, Inc.
+  Written by Andreas Gruenbacher <agruenba@redhat.com>
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/stat.h>
+#include "sys/richacl.h"
+
+/**
+ * richacl_access_cred  -  Determine the permissions of a process
+ * @file:	file name
+ * @st:		status of file @file (or NULL)
+ * @cred:	user and groups to check permissions for
+ *
+ * Returns the permissions granted to a process with credentials @cred.  If
+ * @stat is NULL, stat() is called on @file.  Returns -1 and sets errno on
+ * error.
+ */
+int richacl_access_cred(const char *file, const struct stat *st,
+			const struct richacl_cred *cred)
+{
+	unsigned long buffer[RICHACL_ACCESS_BUFFER_SIZE / sizeof(unsigned long)];
+
+	return richacl_access_buffer(file, st, cred, buffer, sizeof(buffer));
+}
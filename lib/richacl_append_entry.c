@@ -18,7 +18,6 @@
   <http://www.gnu.org/licenses/>.
 */
 
-#include <stdlib.h>
 #include <string.h>
 #include "sys/richacl.h"
 #include "richacl-internal.h"
@@ -28,24 +27,15 @@
  * @alloc:	acl and number of allocated entries
  *
  * Append a new entry to @alloc->acl and zero-initialize it.
- * This may require reallocating @alloc->acl.
+ * This may require reallocating @alloc->acl (see richacl_reserve()).
  */
 struct richace *
 richacl_append_entry(struct richacl_alloc *alloc)
 {
 	struct richace *ace;
 
-	if (alloc->count == alloc->acl->a_count) {
-		size_t size = sizeof(struct richacl) +
-			      (alloc->count + 1) * sizeof(struct richace);
-		struct richacl *acl2;
-
-		acl2 = realloc(alloc->acl, size);
-		if (!acl2)
-			return NULL;
-		alloc->count++;
-		alloc->acl = acl2;
-	}
+	if (richacl_reserve(alloc, alloc->acl->a_count + 1))
+		return NULL;
 	ace = alloc->acl->a_entries + alloc->acl->a_count;
 	alloc->acl->a_count++;
 	memset(ace, 0, sizeof(struct richace));
@@ -19,9 +19,119 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include "sys/richacl.h"
 #include "richacl-internal.h"
 
+/*
+ * Most of the transformations below go through the acl once, and change,
+ * split, or remove entries on the way (see richace_change_mask()).  Instead
+ * of moving the remaining entries each time, they write the resulting
+ * entries to the start of the buffer while reading the original entries.
+ * When entries may be split in two, the original entries are first moved
+ * to the end of a buffer with enough room so that the output never
+ * overtakes the input.
+ */
+
+/**
+ * richacl_rewrite_begin  -  prepare for rewriting all entries
+ * @alloc:	acl and number of allocated entries
+ * @extra:	number of entries added before the last original entry
+ * @in:	first original entry
+ * @end:	end of the original entries
+ *
+ * The acl has no entries afterwards; the original entries need to be passed
+ * to richacl_rewrite_emit() or richacl_rewrite_change_mask() in order.
+ */
+static int
+richacl_rewrite_begin(struct richacl_alloc *alloc, unsigned int extra,
+		      struct richace **in, struct richace **end)
+{
+	unsigned int count = alloc->acl->a_count, room = extra;
+	struct richace *ace;
+
+	/* Only inheritable entries are split. */
+	richacl_for_each_entry(ace, alloc->acl) {
+		if (richace_is_inheritable(ace))
+			room++;
+	}
+	if (richacl_reserve(alloc, count + room))
+		return -1;
+	*in = alloc->acl->a_entries;
+	*end = *in + count;
+	if (room) {
+		*end = alloc->acl->a_entries + alloc->count;
+		*in = *end - count;
+		memmove(*in, alloc->acl->a_entries,
+			count * sizeof(struct richace));
+	}
+	alloc->acl->a_count = 0;
+	return 0;
+}
+
+/**
+ * richacl_rewrite_emit  -  add an entry at the end of the rewritten acl
+ */
+static struct richace *
+richacl_rewrite_emit(struct richacl_alloc *alloc, const struct richace *ace)
+{
+	struct richace *out = alloc->acl->a_entries + alloc->acl->a_count++;
+
+	memmove(out, ace, sizeof(struct richace));
+	return out;
+}
+
+/**
+ * richacl_rewrite_change_mask  -  add an entry with a changed mask
+ *
+ * Like richace_change_mask(), but adds the resulting entries at the end of
+ * the rewritten acl.  Entries which richace_change_mask() would remove are
+ * freed.
+ */
+static int
+richacl_rewrite_change_mask(struct richacl_alloc *alloc, struct richace *ace,
+			    unsigned int mask)
+{
+	/* The output may overwrite *ace when splitting it. */
+	struct richace entry = *ace;
+
+	if (mask && entry.e_mask == mask) {
+		entry.e_flags &= ~RICHACE_INHERIT_ONLY_ACE;
+		richacl_rewrite_emit(alloc, &entry);
+	} else if (mask & ~RICHACE_POSIX_ALWAYS_ALLOWED) {
+		if (richace_is_inheritable(&entry)) {
+			struct richace copy = {};
+
+			if (richace_copy(&copy, &entry))
+				return -1;
+			copy.e_flags |= RICHACE_INHERIT_ONLY_ACE;
+			richacl_rewrite_emit(alloc, &copy);
+			entry.e_flags &= ~RICHACE_INHERITANCE_FLAGS |
+					 RICHACE_INHERITED_ACE;
+		}
+		entry.e_mask = mask;
+		richacl_rewrite_emit(alloc, &entry);
+	} else {
+		if (richace_is_inheritable(&entry)) {
+			entry.e_flags |= RICHACE_INHERIT_ONLY_ACE;
+			richacl_rewrite_emit(alloc, &entry);
+		} else
+			richace_free(&entry);
+	}
+	return 0;
+}
+
+/**
+ * richacl_rewrite_abort  -  keep the remaining entries unchanged after an error
+ */
+static void
+richacl_rewrite_abort(struct richacl_alloc *alloc, struct richace *in,
+		      struct richace *end)
+{
+	for (; in != end; in++)
+		richacl_rewrite_emit(alloc, in);
+}
+
 /**
  * richacl_move_everyone_aces_down  -  move everyone@ acl entries to the end
  * @alloc:	acl and number of allocated entries
@@ -34,47 +144,60 @@
  * This transformation does not modify the permissions that the acl
  * grants, but simplifies successive transformations.
  */
-static int
+int
 richacl_move_everyone_aces_down(struct richacl_alloc *alloc)
 {
-	struct richace *ace;
+	struct richace *in, *end;
 	unsigned int allowed = 0, denied = 0;
 
-	richacl_for_each_entry(ace, alloc->acl) {
-		if (richace_is_inherit_only(ace))
+	if (richacl_rewrite_begin(alloc, 0, &in, &end))
+		return -1;
+	for (; in != end; in++) {
+		unsigned int mask;
+
+		if (richace_is_inherit_only(in)) {
+			richacl_rewrite_emit(alloc, in);
 			continue;
-		if (richace_is_everyone(ace)) {
-			if (richace_is_allow(ace))
-				allowed |= (ace->e_mask & ~denied);
-			else if (richace_is_deny(ace))
-				denied |= (ace->e_mask & ~allowed);
-			else
+		}
+		if (richace_class(in) == RICHACE_CLASS_EVERYONE) {
+			if (richace_is_allow(in))
+				allowed |= (in->e_mask & ~denied);
+			else if (richace_is_deny(in))
+				denied |= (in->e_mask & ~allowed);
+			else {
+				richacl_rewrite_emit(alloc, in);
 				continue;
-			if (richace_change_mask(alloc, &ace, 0))
-				return -1;
+			}
+			mask = 0;
 		} else {
-			if (richace_is_allow(ace)) {
-				if (richace_change_mask(alloc, &ace, allowed |
-						(ace->e_mask & ~denied)))
-					return -1;
-			} else if (richace_is_deny(ace)) {
-				if (richace_change_mask(alloc, &ace, denied |
-						(ace->e_mask & ~allowed)))
-					return -1;
+			if (richace_is_allow(in))
+				mask = allowed | (in->e_mask & ~denied);
+			else if (richace_is_deny(in))
+				mask = denied | (in->e_mask & ~allowed);
+			else {
+				richacl_rewrite_emit(alloc, in);
+				continue;
 			}
 		}
+		if (richacl_rewrite_change_mask(alloc, in, mask)) {
+			richacl_rewrite_abort(alloc, in, end);
+			return -1;
+		}
 	}
 	if (allowed & ~RICHACE_POSIX_ALWAYS_ALLOWED) {
-		struct richace *last_ace = ace - 1;
+		struct richacl *acl = alloc->acl;
+		struct richace *last_ace = acl->a_entries + acl->a_count - 1;
 
-		if (alloc->acl->a_count &&
+		if (acl->a_count &&
 		    richace_is_everyone(last_ace) &&
 		    richace_is_allow(last_ace) &&
 		    richace_is_inherit_only(last_ace) &&
 		    last_ace->e_mask == allowed)
 			last_ace->e_flags &= ~RICHACE_INHERIT_ONLY_ACE;
 		else {
-			if (richacl_insert_entry(alloc, &ace))
+			struct richace *ace = richacl_append_entry(alloc);
+
+			if (!ace)
 				return -1;
 			ace->e_type = RICHACE_ACCESS_ALLOWED_ACE_TYPE;
 			ace->e_flags = RICHACE_SPECIAL_WHO;
@@ -85,6 +208,148 @@ richacl_move_everyone_aces_down(struct richacl_alloc *alloc)
 	return 0;
 }
 
+/**
+ * struct who_update  -  state for updating the group class in one pass
+ * @seen:	mask flags of the entries for this identifier
+ * @target:	entry to add @add to, or the number of entries
+ * @target_seen: @seen up to and including @target
+ * @add:	mask flags to add for this identifier
+ * @mask:	new mask of this entry, or 0
+ * @insert:	mask of a new entry for the identifier of this entry, or 0
+ * @later:	allow mask flags of the entries after this entry
+ * @done:	this identifier has been handled
+ *
+ * The per-identifier fields are indexed by the index of the first entry
+ * with that identifier (see richacl_identifiers()); the other fields are
+ * indexed by entry.
+ */
+struct who_update {
+	unsigned int seen;
+	unsigned int target;
+	unsigned int target_seen;
+	unsigned int add;
+	unsigned int mask;
+	unsigned int insert;
+	unsigned int later;
+	bool done;
+};
+
+/* Small acls do not need to allocate the state. */
+#define WHO_UPDATES_ON_STACK 16
+
+/**
+ * richacl_update_group_class  -  add permissions for the group class identifiers
+ * @alloc:	acl and number of allocated entries
+ * @first:	see richacl_identifiers()
+ * @st:	state, with @seen, @target, and @add set for each identifier
+ * @type:	type of new entries
+ *
+ * For each identifier in the group class other than group@, add @add to
+ * the mask of @target, or insert a new entry of @type before the trailing
+ * everyone@ entry if there is no @target.  The result is the same as what
+ * going through the acl from the end to the start and calling
+ * __richacl_propagate_everyone() or __richacl_isolate_who() for each entry
+ * would produce: that computes the same for all entries with the same
+ * identifier, and only changes something for the first one.
+ *
+ * When a target before the current entry is split in two, the entries
+ * after the target move up by one, and going through the acl by index
+ * skips the entry before the current entry.  Do the same here.
+ *
+ * Returns 1 if a target would end up with no permissions beyond
+ * RICHACE_POSIX_ALWAYS_ALLOWED: richace_change_mask() would remove or
+ * disable that entry, and the result would then depend on the order of
+ * the changes.
+ */
+static int
+richacl_update_group_class(struct richacl_alloc *alloc,
+			   const unsigned int *first, struct who_update *st,
+			   unsigned int type)
+{
+	struct richacl *acl = alloc->acl;
+	unsigned int count = acl->a_count, n, n_new = 0, k = 0;
+	struct richace *new = NULL, *in, *end;
+	bool changed = false, skip = false;
+
+	for (n = count - 1; n-- > 0; ) {
+		struct richace *ace = acl->a_entries + n;
+		unsigned int x = first[n], target;
+
+		if (skip) {
+			skip = false;
+			continue;
+		}
+		if (richace_is_inherit_only(ace))
+			continue;
+		switch (richace_class(ace)) {
+		case RICHACE_CLASS_OWNER:
+		case RICHACE_CLASS_GROUP:
+			continue;
+		}
+		if (st[x].done)
+			continue;
+		st[x].done = true;
+		if (!st[x].add)
+			continue;
+		changed = true;
+		target = st[x].target;
+		if (target == count) {
+			st[n].insert = st[x].add;
+			n_new++;
+		} else {
+			struct richace *target_ace = acl->a_entries + target;
+			unsigned int mask = target_ace->e_mask | st[x].add;
+
+			if (!(mask & ~RICHACE_POSIX_ALWAYS_ALLOWED))
+				return 1;
+			st[target].mask = mask;
+			if (richace_is_inheritable(target_ace) && target < n)
+				skip = true;
+		}
+	}
+	if (!changed)
+		return 0;
+
+	if (n_new) {
+		new = calloc(n_new, sizeof(*new));
+		if (!new)
+			return -1;
+		for (n = count - 1; n-- > 0; ) {
+			if (!st[n].insert)
+				continue;
+			if (richace_copy(new + k, acl->a_entries + n))
+				goto fail_new;
+			new[k].e_type = type;
+			new[k].e_flags &= ~RICHACE_INHERITANCE_FLAGS;
+			new[k].e_mask = st[n].insert;
+			k++;
+		}
+	}
+	if (richacl_rewrite_begin(alloc, n_new, &in, &end))
+		goto fail_new;
+	for (n = 0; in != end; n++, in++) {
+		if (n == count - 1) {
+			for (k = 0; k < n_new; k++)
+				richacl_rewrite_emit(alloc, new + k);
+			k = 0;
+		}
+		if (!st[n].mask)
+			richacl_rewrite_emit(alloc, in);
+		else if (richacl_rewrite_change_mask(alloc, in, st[n].mask)) {
+			richacl_rewrite_abort(alloc, in, end);
+			goto fail_new;
+		}
+	}
+	free(new);
+	return 0;
+
+fail_new:
+	while (k)
+		richace_free(new + --k);
+	free(new);
+	return -1;
+}
+
 /*
  * __richacl_propagate_everyone  -  propagate everyone@ permissions up for @who
  * @alloc:	acl and number of allocated entries
@@ -174,6 +439,110 @@ __richacl_propagate_everyone(struct richacl_alloc *alloc, struct richace *who,
 	return 0;
 }
 
+/**
+ * richacl_propagate_group_class  -  propagate everyone@ permissions up for the group class
+ * @alloc:	acl and number of allocated entries
+ * @allow:	permissions to propagate up
+ *
+ * Propagate @allow up for all identifiers in the group class other than
+ * group@ in a single pass; see richacl_update_group_class().
+ *
+ * __richacl_propagate_everyone() adds the permissions to the last allow
+ * entry for the identifier unless an entry for another identifier after
+ * it denies any of the permissions not yet allowed or denied at that
+ * point.  Of the entries after the last allow entry, only deny entries for
+ * the identifier itself remove permissions, so this is the case when the
+ * first deny entry after the last allow entry which includes one of those
+ * permissions is not for the identifier itself.
+ *
+ * Returns 1 if the permissions need to be propagated up entry by entry.
+ */
+static int
+richacl_propagate_group_class(struct richacl_alloc *alloc, unsigned int allow)
+{
+	struct richacl *acl = alloc->acl;
+	unsigned int count = acl->a_count, next_deny[32], n, *first;
+	struct richace *last = acl->a_entries + count - 1;
+	unsigned int first_on_stack[WHO_UPDATES_ON_STACK];
+	struct who_update *st, st_on_stack[WHO_UPDATES_ON_STACK];
+	int ret = 1;
+
+	if (count <= WHO_UPDATES_ON_STACK) {
+		first = first_on_stack;
+		st = st_on_stack;
+		memset(st, 0, count * sizeof(*st));
+	} else {
+		first = malloc(count * sizeof(*first));
+		st = calloc(count, sizeof(*st));
+	}
+	if (!first || !st || richacl_identifiers(acl, first))
+		goto out;
+
+	for (n = 0; n < count; n++) {
+		struct richace *ace = acl->a_entries + n;
+		struct who_update *who = st + first[n];
+
+		if (n == first[n])
+			who->target = count;
+		if (richace_is_inherit_only(ace))
+			continue;
+		if (richace_is_allow(ace)) {
+			who->seen |= ace->e_mask;
+			who->target = n;
+			who->target_seen = who->seen;
+		} else if (richace_is_deny(ace))
+			who->seen |= ace->e_mask;
+	}
+
+	/* The index of the next deny entry which denies each flag */
+	for (n = 0; n < 32; n++)
+		next_deny[n] = count;
+	for (n = count; n-- > 0; ) {
+		struct richace *ace = acl->a_entries + n;
+		struct who_update *who = st + first[n];
+		unsigned int flags;
+
+		if (richace_is_inherit_only(ace))
+			continue;
+		if (who->target == n) {
+			flags = allow & ~who->target_seen;
+			while (flags) {
+				unsigned int next = next_deny[ffs(flags) - 1];
+
+				flags &= flags - 1;
+				if (next != count && first[next] != first[n]) {
+					who->target = count;
+					break;
+				}
+			}
+		}
+		if (richace_is_deny(ace)) {
+			for (flags = ace->e_mask; flags; flags &= flags - 1)
+				next_deny[ffs(flags) - 1] = n;
+		}
+	}
+
+	for (n = 0; n < count; n++) {
+		struct who_update *who = st + n;
+
+		if (first[n] != n)
+			continue;
+		who->add = allow & ~who->seen;
+		/* See __richacl_propagate_everyone(). */
+		if (!(who->add & ~(last->e_mask & acl->a_other_mask)))
+			who->add = 0;
+	}
+	ret = richacl_update_group_class(alloc, first, st,
+					 RICHACE_ACCESS_ALLOWED_ACE_TYPE);
+
+out:
+	if (first != first_on_stack) {
+		free(first);
+		free(st);
+	}
+	return ret;
+}
+
 /**
  * richacl_propagate_everyone  -  propagate everyone@ mask flags up the acl
  * @alloc:	acl and number of allocated entries
@@ -213,7 +582,7 @@ __richacl_propagate_everyone(struct richacl_alloc *alloc, struct richace *who,
  *    group@:rwp::allow
  *    joe:r::allow
  */
-static int
+int
 richacl_propagate_everyone(struct richacl_alloc *alloc)
 {
 	struct richace who = { .e_flags = RICHACE_SPECIAL_WHO };
@@ -255,7 +624,7 @@ richacl_propagate_everyone(struct richacl_alloc *alloc)
 	 * group and to all other members in the group class.
 	 */
 	if (group_allow & ~acl->a_other_mask) {
-		int n;
+		int n, ret;
 
 		/* Propagate everyone@ permissions through to group@. */
 		who.e_id = RICHACE_GROUP_SPECIAL_ID;
@@ -263,15 +632,23 @@ richacl_propagate_everyone(struct richacl_alloc *alloc)
 			return -1;
 		acl = alloc->acl;
 
-		/* Start from the entry before the trailing everyone@ allow
-		   entry. We will not hit everyone@ entries in the loop. */
+		ret = richacl_propagate_group_class(alloc, group_allow);
+		if (ret != 1)
+			return ret;
+
+		/* Otherwise, go through the entries one by one.  Start from
+		   the entry before the trailing everyone@ allow entry. We
+		   will not hit everyone@ entries in the loop. */
 		for (n = acl->a_count - 2; n != -1; n--) {
 			ace = acl->a_entries + n;
 
-			if (richace_is_inherit_only(ace) ||
-			    richace_is_owner(ace) ||
-			    richace_is_group(ace))
+			if (richace_is_inherit_only(ace))
 				continue;
+			switch (richace_class(ace)) {
+			case RICHACE_CLASS_OWNER:
+			case RICHACE_CLASS_GROUP:
+				continue;
+			}
 
 			/*
 			 * Any inserted entry will end up below the current
@@ -297,22 +674,39 @@ richacl_propagate_everyone(struct richacl_alloc *alloc)
 static int
 __richacl_apply_masks(struct richacl_alloc *alloc, uid_t owner)
 {
-	struct richace *ace;
+	struct richacl *acl = alloc->acl;
+	unsigned int owner_mask = acl->a_owner_mask;
+	unsigned int group_mask = acl->a_group_mask;
+	unsigned int other_mask = acl->a_other_mask;
+	struct richace *in, *end;
 
-	richacl_for_each_entry(ace, alloc->acl) {
+	if (richacl_rewrite_begin(alloc, 0, &in, &end))
+		return -1;
+	for (; in != end; in++) {
 		unsigned int mask;
 
-		if (richace_is_inherit_only(ace) || !richace_is_allow(ace))
+		if (richace_is_inherit_only(in) || !richace_is_allow(in)) {
+			richacl_rewrite_emit(alloc, in);
 			continue;
-		if (richace_is_owner(ace) ||
-		    (richace_is_unix_user(ace) && ace->e_id == owner))
-			mask = alloc->acl->a_owner_mask;
-		else if (richace_is_everyone(ace))
-			mask = alloc->acl->a_other_mask;
-		else
-			mask = alloc->acl->a_group_mask;
-		if (richace_change_mask(alloc, &ace, ace->e_mask & mask))
+		}
+		switch (richace_class(in)) {
+		case RICHACE_CLASS_OWNER:
+			mask = owner_mask;
+			break;
+		case RICHACE_CLASS_UID:
+			mask = in->e_id == owner ? owner_mask : group_mask;
+			break;
+		case RICHACE_CLASS_EVERYONE:
+			mask = other_mask;
+			break;
+		default:
+			mask = group_mask;
+			break;
+		}
+		if (richacl_rewrite_change_mask(alloc, in, in->e_mask & mask)) {
+			richacl_rewrite_abort(alloc, in, end);
 			return -1;
+		}
 	}
 	return 0;
 }
@@ -332,7 +726,7 @@ richacl_max_allowed(struct richacl *acl)
 		if (richace_is_allow(ace))
 			allowed |= ace->e_mask;
 		else if (richace_is_deny(ace)) {
-			if (richace_is_everyone(ace))
+			if (richace_class(ace) == RICHACE_CLASS_EVERYONE)
 				allowed &= ~ace->e_mask;
 		}
 	}
@@ -364,7 +758,7 @@ richacl_isolate_owner_class(struct richacl_alloc *alloc)
 				continue;
 			if (richace_is_allow(ace))
 				break;
-			if (richace_is_owner(ace)) {
+			if (richace_class(ace) == RICHACE_CLASS_OWNER) {
 				return richace_change_mask(alloc, &ace,
 							   ace->e_mask | deny);
 			}
@@ -447,6 +841,80 @@ __richacl_isolate_who(struct richacl_alloc *alloc, struct richace *who,
 	return 0;
 }
 
+/**
+ * richacl_isolate_group_class_fast  -  isolate the group class identifiers
+ * @alloc:	acl and number of allocated entries
+ * @deny:	permissions the group class should not be allowed
+ *
+ * Isolate all identifiers in the group class other than group@ in a single
+ * pass; see richacl_update_group_class().
+ *
+ * __richacl_isolate_who() adds the permissions to the last deny entry for
+ * the identifier unless an allow entry after it allows any of them.
+ *
+ * Returns 1 if the identifiers need to be isolated entry by entry.
+ */
+static int
+richacl_isolate_group_class_fast(struct richacl_alloc *alloc,
+				 unsigned int deny)
+{
+	struct richacl *acl = alloc->acl;
+	unsigned int count = acl->a_count, allowed = 0, n, *first;
+	unsigned int first_on_stack[WHO_UPDATES_ON_STACK];
+	struct who_update *st, st_on_stack[WHO_UPDATES_ON_STACK];
+	int ret = 1;
+
+	if (count <= WHO_UPDATES_ON_STACK) {
+		first = first_on_stack;
+		st = st_on_stack;
+		memset(st, 0, count * sizeof(*st));
+	} else {
+		first = malloc(count * sizeof(*first));
+		st = calloc(count, sizeof(*st));
+	}
+	if (!first || !st || richacl_identifiers(acl, first))
+		goto out;
+
+	for (n = 0; n < count; n++) {
+		struct richace *ace = acl->a_entries + n;
+		struct who_update *who = st + first[n];
+
+		if (n == first[n])
+			who->target = count;
+		if (richace_is_inherit_only(ace))
+			continue;
+		who->seen |= ace->e_mask;
+		/* The trailing everyone@ entry is never a target. */
+		if (richace_is_deny(ace) && n != count - 1)
+			who->target = n;
+	}
+	for (n = count - 1; n-- > 0; ) {
+		struct richace *ace = acl->a_entries + n;
+
+		st[n].later = allowed;
+		if (!richace_is_inherit_only(ace) && richace_is_allow(ace))
+			allowed |= ace->e_mask;
+	}
+	for (n = 0; n < count; n++) {
+		struct who_update *who = st + n;
+
+		if (first[n] != n)
+			continue;
+		who->add = deny & ~who->seen;
+		if (who->target != count && (st[who->target].later & who->add))
+			who->target = count;
+	}
+	ret = richacl_update_group_class(alloc, first, st,
+					 RICHACE_ACCESS_DENIED_ACE_TYPE);
+
+out:
+	if (first != first_on_stack) {
+		free(first);
+		free(st);
+	}
+	return ret;
+}
+
 /**
  * richacl_isolate_group_class  -  limit the group class to the group file mask
  * @alloc:	acl and number of allocated entries
@@ -473,21 +941,30 @@ richacl_isolate_group_class(struct richacl_alloc *alloc, unsigned int deny)
 
 	if (deny) {
 		unsigned int n;
+		int ret;
 
 		if (__richacl_isolate_who(alloc, &who, deny))
 			return -1;
 
+		ret = richacl_isolate_group_class_fast(alloc, deny);
+		if (ret != 1)
+			return ret;
+
 		/*
-		 * Start from the entry before the trailing everyone@ allow
-		 * entry.  We will not hit everyone@ entries in the loop.
+		 * Otherwise, go through the entries one by one.  Start from
+		 * the entry before the trailing everyone@ allow entry.  We
+		 * will not hit everyone@ entries in the loop.
 		 */
 		for (n = alloc->acl->a_count - 2; n != -1; n--) {
 			ace = alloc->acl->a_entries + n;
 
-			if (richace_is_inherit_only(ace) ||
-			    richace_is_owner(ace) ||
-			    richace_is_group(ace))
+			if (richace_is_inherit_only(ace))
+				continue;
+			switch (richace_class(ace)) {
+			case RICHACE_CLASS_OWNER:
+			case RICHACE_CLASS_GROUP:
 				continue;
+			}
 			if (__richacl_isolate_who(alloc, ace, deny))
 				return -1;
 		}
@@ -504,21 +981,29 @@ richacl_set_owner_permissions(struct richacl_alloc *alloc)
 	unsigned int x = RICHACE_POSIX_ALWAYS_ALLOWED;
 	unsigned int owner_mask = alloc->acl->a_owner_mask & ~x;
 	unsigned int denied = 0;
-	struct richace *ace;
+	struct richace *ace, *in, *end;
 
 	if (!((alloc->acl->a_flags & RICHACL_WRITE_THROUGH)))
 		return 0;
 
-	richacl_for_each_entry(ace, alloc->acl) {
-		if (richace_is_owner(ace)) {
-			if (richace_is_allow(ace) && !(owner_mask & denied)) {
-				richace_change_mask(alloc, &ace, owner_mask);
+	if (richacl_rewrite_begin(alloc, 0, &in, &end))
+		return -1;
+	for (; in != end; in++) {
+		if (richace_class(in) == RICHACE_CLASS_OWNER) {
+			unsigned int mask = 0;
+
+			if (richace_is_allow(in) && !(owner_mask & denied)) {
+				mask = owner_mask;
 				owner_mask = 0;
-			} else
-				richace_change_mask(alloc, &ace, 0);
+			}
+			if (richacl_rewrite_change_mask(alloc, in, mask)) {
+				richacl_rewrite_abort(alloc, in, end);
+				return -1;
+			}
 		} else {
-			if (richace_is_deny(ace))
-				denied |= ace->e_mask;
+			if (richace_is_deny(in))
+				denied |= in->e_mask;
+			richacl_rewrite_emit(alloc, in);
 		}
 	}
 
@@ -570,6 +1055,28 @@ richacl_set_other_permissions(struct richacl_alloc *alloc, unsigned int *added)
 	return 0;
 }
 
+/**
+ * richacl_apply_masks_normalized  -  apply the masks after propagating everyone@
+ * @alloc:	acl and number of allocated entries
+ * @owner:	file owner
+ *
+ * The remaining steps of richacl_apply_masks() after
+ * richacl_move_everyone_aces_down() and richacl_propagate_everyone().
+ */
+int
+richacl_apply_masks_normalized(struct richacl_alloc *alloc, uid_t owner)
+{
+	unsigned int added = 0;
+
+	if (__richacl_apply_masks(alloc, owner) ||
+	    richacl_set_other_permissions(alloc, &added) ||
+	    richacl_isolate_group_class(alloc, added) ||
+	    richacl_set_owner_permissions(alloc) ||
+	    richacl_isolate_owner_class(alloc))
+		return -1;
+	return 0;
+}
+
 /**
  * richacl_apply_masks  -  apply the masks to the acl
  *
@@ -586,22 +1093,27 @@ richacl_apply_masks(struct richacl **acl, uid_t owner)
 	int retval = 0;
 
 	if ((*acl)->a_flags & RICHACL_MASKED) {
+		unsigned int count = (*acl)->a_count;
 		struct richacl_alloc alloc = {
 			.acl = *acl,
-			.count = (*acl)->a_count,
+			.count = count,
 		};
-		unsigned int added = 0;
 
 		if (richacl_move_everyone_aces_down(&alloc) ||
 		    richacl_propagate_everyone(&alloc) ||
-		    __richacl_apply_masks(&alloc, owner) ||
-		    richacl_set_other_permissions(&alloc, &added) ||
-		    richacl_isolate_group_class(&alloc, added) ||
-		    richacl_set_owner_permissions(&alloc) ||
-		    richacl_isolate_owner_class(&alloc))
+		    richacl_apply_masks_normalized(&alloc, owner))
 				retval = -1;
 
 		alloc.acl->a_flags &= ~(RICHACL_WRITE_THROUGH | RICHACL_MASKED);
+		if (alloc.count > count && alloc.count > alloc.acl->a_count) {
+			/* Give back the room needed during the transformation. */
+			struct richacl *acl2 = realloc(alloc.acl,
+				sizeof(struct richacl) +
+				alloc.acl->a_count * sizeof(struct richace));
+
+			if (acl2)
+				alloc.acl = acl2;
+		}
 		*acl = alloc.acl;
 	}
 	return retval;
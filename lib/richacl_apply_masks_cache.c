@@ -0,0 +1,137 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+static struct richacl_masks_cache_entry *
+find_entry(struct richacl_masks_cache *cache, uint64_t hash, uid_t owner,
+	   const struct richacl *acl)
+{
+	struct richacl_masks_cache_entry *entry;
+	int n;
+
+	entry = cache->mc_entries +
+		(richacl_hash_u32(hash, owner) % cache->mc_n_sets) *
+		RICHACL_CACHE_WAYS;
+	for (n = 0; n < RICHACL_CACHE_WAYS; n++, entry++) {
+		if (entry->me_acl && entry->me_hash == hash &&
+		    entry->me_owner == owner &&
+		    richacl_equal(entry->me_acl, acl))
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * Remember @result for @acl and @owner.  The result is silently not
+ * remembered when @acl cannot be added to the store.
+ */
+static void insert_entry(struct richacl_masks_cache *cache, uint64_t hash,
+			 uid_t owner, const struct richacl *acl,
+			 const struct richacl *result)
+{
+	const struct richacl *old_acl = NULL, *old_result = NULL;
+	struct richacl_masks_cache_entry *entry, *victim;
+	const struct richacl *shared;
+	int n;
+
+	shared = richacl_intern(cache->mc_store, acl);
+	if (!shared)
+		return;
+	pthread_mutex_lock(&cache->mc_lock);
+	if (find_entry(cache, hash, owner, acl)) {
+		/* Another thread was faster. */
+		old_acl = shared;
+		goto out;
+	}
+	entry = cache->mc_entries +
+		(richacl_hash_u32(hash, owner) % cache->mc_n_sets) *
+		RICHACL_CACHE_WAYS;
+	victim = entry;
+	for (n = 0; n < RICHACL_CACHE_WAYS; n++, entry++) {
+		if (!entry->me_acl) {
+			victim = entry;
+			break;
+		}
+		if (entry->me_used < victim->me_used)
+			victim = entry;
+	}
+	old_acl = victim->me_acl;
+	old_result = victim->me_result;
+	victim->me_hash = hash;
+	victim->me_owner = owner;
+	victim->me_acl = shared;
+	victim->me_result = richacl_intern_get(result);
+	victim->me_used = ++cache->mc_clock;
+out:
+	pthread_mutex_unlock(&cache->mc_lock);
+	richacl_intern_put(old_acl);
+	richacl_intern_put(old_result);
+}
+
+/**
+ * richacl_apply_masks_cache  -  apply the file masks, remembering the result
+ * @cache:	cache from richacl_masks_cache_alloc()
+ * @acl:	acl to apply the file masks to
+ * @owner:	file owner
+ *
+ * Computes the same acl as richacl_apply_masks(), but leaves @acl alone.
+ * When the masks have already been applied to an identical acl for the
+ * same owner, the remembered result is returned without computing it
+ * again.
+ *
+ * Returns the shared result from the store of @cache with a new reference,
+ * which is dropped with richacl_intern_put(), or NULL with errno set on
+ * error.  The result must not be modified.
+ */
+const struct richacl *
+richacl_apply_masks_cache(struct richacl_masks_cache *cache,
+			  const struct richacl *acl, uid_t owner)
+{
+	uint64_t hash = richacl_hash(acl);
+	struct richacl_masks_cache_entry *entry;
+	const struct richacl *result;
+	struct richacl *copy;
+
+	pthread_mutex_lock(&cache->mc_lock);
+	entry = find_entry(cache, hash, owner, acl);
+	if (entry) {
+		entry->me_used = ++cache->mc_clock;
+		result = richacl_intern_get(entry->me_result);
+		cache->mc_hits++;
+		pthread_mutex_unlock(&cache->mc_lock);
+		return result;
+	}
+	cache->mc_misses++;
+	pthread_mutex_unlock(&cache->mc_lock);
+
+	/* Compute the result without holding the lock. */
+	copy = richacl_clone(acl);
+	if (!copy)
+		return NULL;
+	if (richacl_apply_masks(&copy, owner)) {
+		richacl_free(copy);
+		return NULL;
+	}
+	result = richacl_intern(cache->mc_store, copy);
+	richacl_free(copy);
+	if (result)
+		insert_entry(cache, hash, owner, acl, result);
+	return result;
+}
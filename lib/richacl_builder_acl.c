@@ -0,0 +1,33 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_builder_acl  -  the acl a builder is building
+ *
+ * The acl flags, masks, and the entry masks and flags can be changed
+ * directly; entries must only be added or removed through the builder.
+ * The acl may move when entries are added, so the result is only valid
+ * until the next richacl_builder_reserve() or richacl_builder_insert().
+ */
+struct richacl *richacl_builder_acl(struct richacl_builder *builder)
+{
+	return builder->b_alloc.acl;
+}
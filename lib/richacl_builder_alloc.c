@@ -0,0 +1,50 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_builder_alloc  -  start building or editing an acl
+ * @acl:	acl to edit, or NULL to start with an empty acl
+ *
+ * The builder takes over @acl; get the result with richacl_builder_finish(),
+ * or discard it with richacl_builder_free().  If the builder cannot be
+ * allocated, @acl remains with the caller.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_builder *richacl_builder_alloc(struct richacl *acl)
+{
+	struct richacl_builder *builder;
+
+	builder = malloc(sizeof(*builder));
+	if (!builder)
+		return NULL;
+	if (!acl) {
+		acl = richacl_alloc(0);
+		if (!acl) {
+			free(builder);
+			return NULL;
+		}
+	}
+	builder->b_alloc.acl = acl;
+	builder->b_alloc.count = acl->a_count;
+	return builder;
+}
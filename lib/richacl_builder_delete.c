@@ -0,0 +1,51 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_builder_delete  -  delete several entries at once
+ * @builder:	builder to delete from
+ * @which:	indices of the entries to delete, in increasing order
+ * @count:	number of entries to delete
+ *
+ * Each remaining entry is moved at most once, so this takes O(n) time.
+ * The allocation is not shrunk; entries added later reuse the space (see
+ * richacl_builder_finish()).
+ */
+void richacl_builder_delete(struct richacl_builder *builder,
+			    const unsigned int *which, unsigned int count)
+{
+	struct richacl *acl = builder->b_alloc.acl;
+	unsigned int n, i, j;
+
+	if (!count)
+		return;
+	n = which[0];
+	for (i = 0; i < count; i++) {
+		richace_free(acl->a_entries + which[i]);
+		j = (i + 1 < count ? which[i + 1] : acl->a_count) -
+		    (which[i] + 1);
+		memmove(acl->a_entries + n, acl->a_entries + which[i] + 1,
+			j * sizeof(struct richace));
+		n += j;
+	}
+	acl->a_count = n;
+}
@@ -0,0 +1,47 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_builder_finish  -  get the acl a builder has built
+ *
+ * Frees @builder and returns its acl, trimmed to the number of entries it
+ * has.  The result is freed with richacl_free().
+ */
+struct richacl *richacl_builder_finish(struct richacl_builder *builder)
+{
+	struct richacl *acl = builder->b_alloc.acl;
+
+	/*
+	 * The acl remains valid when trimming fails; it then keeps the
+	 * unused entries.
+	 */
+	if (builder->b_alloc.count > acl->a_count) {
+		struct richacl *acl2;
+
+		acl2 = realloc(acl, sizeof(struct richacl) +
+				    acl->a_count * sizeof(struct richace));
+		if (acl2)
+			acl = acl2;
+	}
+	free(builder);
+	return acl;
+}
@@ -0,0 +1,92 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_builder_insert  -  insert entries at several positions at once
+ * @builder:	builder to insert into
+ * @where:	for each new entry, the index of the existing entry it is
+ *		inserted before, in non-decreasing order
+ * @aces:	entries to insert
+ * @count:	number of entries to insert
+ *
+ * Insert a copy of @aces[i] before the entry at index @where[i], or at the
+ * end of the acl when @where[i] is the number of entries.  Entries
+ * inserted at the same index end up in the order in which they are given.
+ * The indices refer to the acl before the insertion; each existing entry
+ * is moved at most once, so this takes O(n + @count) time.
+ *
+ * Returns -1 and sets errno on error; the acl remains unchanged then.
+ */
+int richacl_builder_insert(struct richacl_builder *builder,
+			   const unsigned int *where,
+			   const struct richace *aces, unsigned int count)
+{
+	struct richacl *acl;
+	unsigned int n, i, j;
+
+	if (!count)
+		return 0;
+	if (where[count - 1] > builder->b_alloc.acl->a_count) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (richacl_reserve(&builder->b_alloc,
+			    builder->b_alloc.acl->a_count + count))
+		return -1;
+	acl = builder->b_alloc.acl;
+
+	/*
+	 * Move the existing entries into place from the back, leaving
+	 * zero-initialized gaps for the new entries.
+	 */
+	n = acl->a_count;
+	for (i = count; i > 0; i--) {
+		j = where[i - 1];
+		memmove(acl->a_entries + j + i, acl->a_entries + j,
+			(n - j) * sizeof(struct richace));
+		memset(acl->a_entries + j + i - 1, 0, sizeof(struct richace));
+		n = j;
+	}
+	acl->a_count += count;
+
+	for (i = 0; i < count; i++) {
+		if (richace_copy(acl->a_entries + where[i] + i, &aces[i]))
+			goto fail;
+	}
+	return 0;
+
+fail:
+	/* Remove the new entries again. */
+	for (j = 0; j < i; j++)
+		richace_free(acl->a_entries + where[j] + j);
+	n = where[0];
+	for (i = 0; i < count; i++) {
+		j = (i + 1 < count ? where[i + 1] : acl->a_count - count) -
+		    where[i];
+		memmove(acl->a_entries + n, acl->a_entries + n + i + 1,
+			j * sizeof(struct richace));
+		n += j;
+	}
+	acl->a_count -= count;
+	return -1;
+}
@@ -0,0 +1,52 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_builder_replace  -  replace several entries at once
+ * @builder:	builder to replace entries in
+ * @which:	indices of the entries to replace
+ * @aces:	new entries
+ * @count:	number of entries to replace
+ *
+ * Replace the entry at index @which[i] with a copy of @aces[i].  This takes
+ * O(@count) time.
+ *
+ * Returns -1 and sets errno on error; the entries before the failing one
+ * have been replaced then.
+ */
+int richacl_builder_replace(struct richacl_builder *builder,
+			    const unsigned int *which,
+			    const struct richace *aces, unsigned int count)
+{
+	struct richacl *acl = builder->b_alloc.acl;
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		if (which[i] >= acl->a_count) {
+			errno = EINVAL;
+			return -1;
+		}
+		if (richace_copy(acl->a_entries + which[i], &aces[i]))
+			return -1;
+	}
+	return 0;
+}
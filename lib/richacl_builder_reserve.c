@@ -0,0 +1,37 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_builder_reserve  -  make room for more entries
+ * @builder:	builder to grow
+ * @count:	total number of entries needed
+ *
+ * Make sure that the acl can grow to @count entries without being
+ * reallocated.  The allocation grows geometrically, so adding entries one
+ * at a time takes amortized constant time even without reserving room
+ * first; reserving only avoids the intermediate steps.
+ *
+ * Returns -1 and sets errno on error; the acl remains unchanged then.
+ */
+int richacl_builder_reserve(struct richacl_builder *builder, unsigned int count)
+{
+	return richacl_reserve(&builder->b_alloc, count);
+}
@@ -0,0 +1,113 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+struct bulk_access {
+	const int *dirfds;
+	const char *const *names;
+	int flags;
+	const struct richacl_cred *cred;
+	int *granted;
+	int *errors;
+	unsigned int failed;
+};
+
+/* Like richacl_access_buffer(), but relative to @dirfd. */
+static int access_at(int dirfd, const char *name, int flags,
+		     const struct richacl_cred *cred)
+{
+	unsigned long buffer[RICHACL_ACCESS_BUFFER_SIZE / sizeof(unsigned long)];
+	struct richacl_xattr_view view;
+	struct richacl *acl;
+	struct stat st;
+	ssize_t len;
+	int allowed;
+
+	if (fstatat(dirfd, name, &st, flags))
+		return -1;
+	len = richacl_getxattr_at(dirfd, name, flags, buffer, sizeof(buffer));
+	if (len >= 0) {
+		if (richacl_xattr_view_init(&view, buffer, len))
+			return -1;
+		return richacl_xattr_view_access(&view, &st, cred);
+	}
+	if (errno == ENODATA || errno == ENOTSUP || errno == ENOSYS)
+		return richacl_access_acl(NULL, &st, cred);
+	if (errno != ERANGE)
+		return -1;
+	acl = richacl_get_at(dirfd, name, flags);
+	if (!acl)
+		return -1;
+	allowed = richacl_access_acl(acl, &st, cred);
+	richacl_free(acl);
+	return allowed;
+}
+
+static void access_one(void *arg, unsigned int n)
+{
+	struct bulk_access *bulk = arg;
+	int dirfd = bulk->dirfds ? bulk->dirfds[n] : AT_FDCWD;
+	int error = 0;
+
+	bulk->granted[n] = access_at(dirfd, bulk->names[n], bulk->flags,
+				     bulk->cred);
+	if (bulk->granted[n] < 0) {
+		error = errno;
+		__atomic_fetch_add(&bulk->failed, 1, __ATOMIC_RELAXED);
+	}
+	if (bulk->errors)
+		bulk->errors[n] = error;
+}
+
+/**
+ * richacl_bulk_access  -  determine the permissions of a process for many files
+ * @pool:	workers to use, or NULL to do all the work in the calling thread
+ * @count:	number of files
+ * @dirfds:	directory file descriptor for each file, or NULL for AT_FDCWD
+ * @names:	name of each file, resolved as in richacl_get_at()
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ * @cred:	user and groups to check permissions for
+ * @granted:	permissions granted for each file, as returned by
+ *		richacl_access_cred(), or -1 on error
+ * @errors:	0 or the errno value for each file (or NULL)
+ *
+ * Returns the number of files for which determining the permissions failed.
+ */
+int richacl_bulk_access(struct richacl_pool *pool, unsigned int count,
+			const int *dirfds, const char *const *names, int flags,
+			const struct richacl_cred *cred, int *granted,
+			int *errors)
+{
+	struct bulk_access bulk = {
+		.dirfds = dirfds,
+		.names = names,
+		.flags = flags,
+		.cred = cred,
+		.granted = granted,
+		.errors = errors,
+	};
+
+	richacl_pool_run(pool, count, access_one, &bulk);
+	return bulk.failed;
+}
@@ -0,0 +1,74 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+struct bulk_get {
+	const int *dirfds;
+	const char *const *names;
+	int flags;
+	struct richacl **acls;
+	int *errors;
+	unsigned int failed;
+};
+
+static void get_one(void *arg, unsigned int n)
+{
+	struct bulk_get *bulk = arg;
+	int dirfd = bulk->dirfds ? bulk->dirfds[n] : AT_FDCWD;
+	int error = 0;
+
+	bulk->acls[n] = richacl_get_at(dirfd, bulk->names[n], bulk->flags);
+	if (!bulk->acls[n]) {
+		error = errno;
+		__atomic_fetch_add(&bulk->failed, 1, __ATOMIC_RELAXED);
+	}
+	if (bulk->errors)
+		bulk->errors[n] = error;
+}
+
+/**
+ * richacl_bulk_get  -  get the acls of many files
+ * @pool:	workers to use, or NULL to do all the work in the calling thread
+ * @count:	number of files
+ * @dirfds:	directory file descriptor for each file, or NULL for AT_FDCWD
+ * @names:	name of each file, resolved as in richacl_get_at()
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ * @acls:	acl of each file, or NULL on error
+ * @errors:	0 or the errno value for each file (or NULL)
+ *
+ * Returns the number of files for which getting the acl failed.
+ */
+int richacl_bulk_get(struct richacl_pool *pool, unsigned int count,
+		     const int *dirfds, const char *const *names, int flags,
+		     struct richacl **acls, int *errors)
+{
+	struct bulk_get bulk = {
+		.dirfds = dirfds,
+		.names = names,
+		.flags = flags,
+		.acls = acls,
+		.errors = errors,
+	};
+
+	richacl_pool_run(pool, count, get_one, &bulk);
+	return bulk.failed;
+}
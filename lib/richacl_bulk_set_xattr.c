@@ -0,0 +1,81 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+struct bulk_set_xattr {
+	const int *dirfds;
+	const char *const *names;
+	int flags;
+	const void *value;
+	size_t size;
+	int *errors;
+	unsigned int failed;
+};
+
+static void set_one(void *arg, unsigned int n)
+{
+	struct bulk_set_xattr *bulk = arg;
+	int dirfd = bulk->dirfds ? bulk->dirfds[n] : AT_FDCWD;
+	int error = 0;
+
+	if (richacl_setxattr_at(dirfd, bulk->names[n], bulk->flags,
+				bulk->value, bulk->size)) {
+		error = errno;
+		__atomic_fetch_add(&bulk->failed, 1, __ATOMIC_RELAXED);
+	}
+	if (bulk->errors)
+		bulk->errors[n] = error;
+}
+
+/**
+ * richacl_bulk_set_xattr  -  set the same encoded acl on many files
+ * @pool:	workers to use, or NULL to do all the work in the calling thread
+ * @count:	number of files
+ * @dirfds:	directory file descriptor for each file, or NULL for AT_FDCWD
+ * @names:	name of each file, resolved as in richacl_set_at()
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ * @value:	acl in xattr format, as produced by richacl_to_xattr()
+ * @size:	size of @value
+ * @errors:	0 or the errno value for each file (or NULL)
+ *
+ * Writes @value to all the files without encoding it again for each file,
+ * as when all the children of a directory inherit the same acl.
+ *
+ * Returns the number of files for which setting the acl failed.
+ */
+int richacl_bulk_set_xattr(struct richacl_pool *pool, unsigned int count,
+			   const int *dirfds, const char *const *names,
+			   int flags, const void *value, size_t size,
+			   int *errors)
+{
+	struct bulk_set_xattr bulk = {
+		.dirfds = dirfds,
+		.names = names,
+		.flags = flags,
+		.value = value,
+		.size = size,
+		.errors = errors,
+	};
+
+	richacl_pool_run(pool, count, set_one, &bulk);
+	return bulk.failed;
+}
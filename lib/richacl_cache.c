@@ -0,0 +1,172 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+static bool same_key(const struct richacl_cache_key *key1,
+		     const struct richacl_cache_key *key2)
+{
+	return key1->k_hash == key2->k_hash &&
+	       key1->k_cred == key2->k_cred &&
+	       key1->k_owner == key2->k_owner &&
+	       key1->k_owning_group == key2->k_owning_group &&
+	       key1->k_kind == key2->k_kind &&
+	       key1->k_mask == key2->k_mask;
+}
+
+static struct richacl_cache_entry *
+cache_set(struct richacl_cache *cache, const struct richacl_cache_key *key)
+{
+	uint64_t hash = key->k_hash;
+
+	hash = richacl_hash_u32(hash, key->k_cred);
+	hash = richacl_hash_u32(hash, key->k_cred >> 32);
+	hash = richacl_hash_u32(hash, key->k_owner);
+	hash = richacl_hash_u32(hash, key->k_owning_group);
+	hash = richacl_hash_u32(hash, key->k_kind);
+	hash = richacl_hash_u32(hash, key->k_mask);
+	return cache->c_entries +
+	       (hash % cache->c_n_sets) * RICHACL_CACHE_WAYS;
+}
+
+static struct richacl_cache_entry *
+find_entry(struct richacl_cache *cache, const struct richacl_cache_key *key,
+	   const struct richacl *acl)
+{
+	struct richacl_cache_entry *entry = cache_set(cache, key);
+	int n;
+
+	for (n = 0; n < RICHACL_CACHE_WAYS; n++, entry++) {
+		if (entry->ce_acl && same_key(&entry->ce_key, key) &&
+		    richacl_equal(entry->ce_acl, acl))
+			return entry;
+	}
+	return NULL;
+}
+
+/**
+ * richacl_cache_key  -  compute the cache key of a decision
+ * @key:	key to initialize
+ * @kind:	RICHACL_CACHE_PERMISSION or RICHACL_CACHE_ACCESS_*
+ * @mask:	requested permissions (RICHACL_CACHE_PERMISSION only)
+ *
+ * Returns false when the decision cannot be cached: the user and group
+ * entries of unmapped identifiers do not have ids, and credentials not
+ * allocated by richacl_cred_alloc() do not have serial numbers.
+ */
+bool richacl_cache_key(struct richacl_cache_key *key,
+		       const struct richacl *acl, uid_t owner,
+		       gid_t owning_group, const struct richacl_cred *cred,
+		       unsigned int kind, unsigned int mask)
+{
+	const struct richace *ace;
+
+	if (!cred->cr_serial)
+		return false;
+	richacl_for_each_entry(ace, acl) {
+		if (ace->e_flags & RICHACE_UNMAPPED_WHO)
+			return false;
+	}
+	key->k_hash = richacl_hash(acl);
+	key->k_cred = cred->cr_serial;
+	key->k_owner = owner;
+	key->k_owning_group = owning_group;
+	key->k_kind = kind;
+	key->k_mask = mask;
+	return true;
+}
+
+/**
+ * richacl_cache_lookup  -  look up a decision
+ * @granted:	permissions granted (on success)
+ *
+ * Returns true and sets @granted if the decision for @key and @acl is
+ * cached.
+ */
+bool richacl_cache_lookup(struct richacl_cache *cache,
+			  const struct richacl_cache_key *key,
+			  const struct richacl *acl, unsigned int *granted)
+{
+	struct richacl_cache_entry *entry;
+
+	pthread_mutex_lock(&cache->c_lock);
+	entry = find_entry(cache, key, acl);
+	if (entry) {
+		entry->ce_used = ++cache->c_clock;
+		*granted = entry->ce_granted;
+		cache->c_hits++;
+	} else
+		cache->c_misses++;
+	pthread_mutex_unlock(&cache->c_lock);
+	return entry != NULL;
+}
+
+/**
+ * richacl_cache_insert  -  remember a decision
+ *
+ * Replaces the least recently used entry in the set of @key if the set is
+ * full.  The decision is silently not remembered when copying @acl fails.
+ */
+void richacl_cache_insert(struct richacl_cache *cache,
+			  const struct richacl_cache_key *key,
+			  const struct richacl *acl, unsigned int granted)
+{
+	struct richacl_cache_entry *entry, *victim;
+	int n;
+
+	pthread_mutex_lock(&cache->c_lock);
+	victim = find_entry(cache, key, acl);
+	if (victim)
+		goto out;
+	entry = cache_set(cache, key);
+	victim = entry;
+	for (n = 0; n < RICHACL_CACHE_WAYS; n++, entry++) {
+		if (!entry->ce_acl) {
+			victim = entry;
+			break;
+		}
+		if (entry->ce_used < victim->ce_used)
+			victim = entry;
+	}
+	if (victim->ce_size < acl->a_count || !victim->ce_acl) {
+		struct richacl *copy;
+
+		copy = realloc(victim->ce_acl, sizeof(struct richacl) +
+			       acl->a_count * sizeof(struct richace));
+		if (!copy) {
+			free(victim->ce_acl);
+			victim->ce_acl = NULL;
+			victim->ce_size = 0;
+			goto unlock;
+		}
+		victim->ce_acl = copy;
+		victim->ce_size = acl->a_count;
+	}
+	memcpy(victim->ce_acl, acl, sizeof(struct richacl) +
+	       acl->a_count * sizeof(struct richace));
+	victim->ce_key = *key;
+
+out:
+	victim->ce_granted = granted;
+	victim->ce_used = ++cache->c_clock;
+unlock:
+	pthread_mutex_unlock(&cache->c_lock);
+}
@@ -0,0 +1,57 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_cache_alloc  -  allocate an access decision cache
+ * @size:	maximum number of decisions to remember
+ *
+ * The cache remembers the results of richacl_permission_cache() and
+ * richacl_access_cache() for acls with the same contents, the same file
+ * owner and owning group, the same credentials from richacl_cred_alloc(),
+ * and the same requested permissions, so that repeated checks against
+ * identical acls do not need to evaluate the acl entries again.  When the
+ * cache is full, the least recently used decisions are replaced.  The
+ * cache can be shared between threads.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_cache *richacl_cache_alloc(unsigned int size)
+{
+	struct richacl_cache *cache;
+	unsigned int n_sets;
+
+	n_sets = (size + RICHACL_CACHE_WAYS - 1) / RICHACL_CACHE_WAYS;
+	if (!n_sets)
+		n_sets = 1;
+	cache = calloc(1, sizeof(*cache) + n_sets * RICHACL_CACHE_WAYS *
+			  sizeof(struct richacl_cache_entry));
+	if (!cache)
+		return NULL;
+	errno = pthread_mutex_init(&cache->c_lock, NULL);
+	if (errno) {
+		free(cache);
+		return NULL;
+	}
+	cache->c_n_sets = n_sets;
+	return cache;
+}
@@ -0,0 +1,38 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_cache_stats  -  report how well a decision cache works
+ * @hits:	number of decisions found in the cache (or NULL)
+ * @misses:	number of decisions not found in the cache (or NULL)
+ *
+ * Checks which cannot be cached are not counted.
+ */
+void richacl_cache_stats(struct richacl_cache *cache, unsigned long *hits,
+			 unsigned long *misses)
+{
+	pthread_mutex_lock(&cache->c_lock);
+	if (hits)
+		*hits = cache->c_hits;
+	if (misses)
+		*misses = cache->c_misses;
+	pthread_mutex_unlock(&cache->c_lock);
+}
@@ -32,13 +32,14 @@ struct richacl *richacl_clone(const struct richacl *acl)
 		return NULL;
 	size = sizeof(struct richacl) + acl->a_count * sizeof(struct richace);
 	acl2 = malloc(size);
-	if (acl2)
-		memcpy(acl2, acl, size);
+	if (!acl2)
+		return NULL;
+	memcpy(acl2, acl, size);
 	richacl_for_each_entry(ace2, acl2) {
 		if (ace2->e_flags & RICHACE_UNMAPPED_WHO) {
 			ace2->e_who = strdup(ace2->e_who);
 			if (!ace2->e_who) {
-				while (ace2 != acl->a_entries) {
+				while (ace2 != acl2->a_entries) {
 					ace2--;
 					if (ace2->e_flags & RICHACE_UNMAPPED_WHO)
 						free(ace2->e_who);
@@ -23,29 +23,10 @@
 /**
  * richacl_compare  -  compare two acls
  *
- * Returns 0 if the two acls are identical.
+ * Returns 0 if the two acls are identical (see richacl_equal()).
  */
 int
 richacl_compare(const struct richacl *a1, const struct richacl *a2)
 {
-	const struct richace *e1, *e2;
-
-	if (a1->a_flags != a2->a_flags ||
-	    a1->a_count != a2->a_count ||
-	    a1->a_owner_mask != a2->a_owner_mask ||
-	    a1->a_group_mask != a2->a_group_mask ||
-	    a1->a_other_mask != a2->a_other_mask)
-		return -1;
-
-	e1 = a1->a_entries;
-	richacl_for_each_entry(e2, a2) {
-		if (e1->e_type != e2->e_type ||
-		    e1->e_flags != e2->e_flags ||
-		    e1->e_mask != e2->e_mask)
-			return -1;
-		if (e1->e_id != e2->e_id)
-			return -1;
-		e1++;
-	}
-	return 0;
+	return richacl_equal(a1, a2) ? 0 : -1;
 }
@@ -0,0 +1,205 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+enum {
+	COMPILE_OWNER,
+	COMPILE_GROUP,
+	COMPILE_EVERYONE,
+	COMPILE_USER,
+	COMPILE_UNIX_GROUP,
+};
+
+struct compile_entry {
+	int kind;
+	id_t id;
+	unsigned int pos;
+	unsigned int mask;
+	unsigned int deny;
+};
+
+static int compile_entry_cmp(const void *a, const void *b)
+{
+	const struct compile_entry *e1 = a, *e2 = b;
+
+	if (e1->kind != e2->kind)
+		return e1->kind < e2->kind ? -1 : 1;
+	if (e1->id != e2->id)
+		return e1->id < e2->id ? -1 : 1;
+	return e1->pos < e2->pos ? -1 : e1->pos > e2->pos;
+}
+
+static struct richacl_compiled_who *
+compiled_who(struct richacl_compiled *compiled, int kind)
+{
+	switch(kind) {
+	case COMPILE_OWNER:
+		return &compiled->c_owner;
+	case COMPILE_GROUP:
+		return &compiled->c_group;
+	case COMPILE_EVERYONE:
+		return &compiled->c_everyone;
+	case COMPILE_USER:
+		return compiled->c_users + compiled->c_n_users++;
+	default:
+		return compiled->c_groups + compiled->c_n_groups++;
+	}
+}
+
+/**
+ * richacl_compile  -  prepare an acl for repeated permission checks
+ * @acl:	acl to compile
+ *
+ * Group the entries of @acl by principal, drop the entries and mask flags
+ * which can never decide a permission check, and precompute the result for
+ * processes which only match owner@, group@, and everyone@ entries.  The
+ * result can be passed to richacl_compiled_permission() until it is freed
+ * with richacl_compiled_free(); it does not refer back to @acl.
+ *
+ * Entries with unmapped identifiers never match a process.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_compiled *richacl_compile(const struct richacl *acl)
+{
+	struct compile_entry *entries, *e, *end;
+	const struct richace *ace;
+	struct richacl_compiled *compiled = NULL;
+	struct richacl_compiled_who *who = NULL;
+	struct richacl_eval ev;
+	unsigned int n_entries = 0, n_users = 0, n_groups = 0;
+	unsigned int seen = 0;
+	size_t size;
+	int n;
+
+	entries = malloc((acl->a_count + 1) * sizeof(*entries));
+	if (!entries)
+		return NULL;
+	/* Only the file masks of @ev matter here. */
+	richacl_eval_init(&ev, acl->a_flags, acl->a_owner_mask,
+			  acl->a_group_mask, acl->a_other_mask, false, false,
+			  0, 0);
+	end = entries;
+	richacl_for_each_entry(ace, acl) {
+		unsigned int mask = ace->e_mask;
+
+		if (richace_is_inherit_only(ace))
+			continue;
+		switch (richace_class(ace)) {
+		case RICHACE_CLASS_OWNER:
+			end->kind = COMPILE_OWNER;
+			break;
+		case RICHACE_CLASS_GROUP:
+			end->kind = COMPILE_GROUP;
+			break;
+		case RICHACE_CLASS_UID:
+			end->kind = COMPILE_USER;
+			break;
+		case RICHACE_CLASS_GID:
+			end->kind = COMPILE_UNIX_GROUP;
+			break;
+		case RICHACE_CLASS_EVERYONE:
+			end->kind = COMPILE_EVERYONE;
+			break;
+		default:
+			continue;
+		}
+
+		mask = richacl_eval_ace_mask(&ev, richace_class(ace),
+					     ace->e_type, mask);
+
+		end->id = end->kind >= COMPILE_USER ? ace->e_id : 0;
+		end->pos = ace - acl->a_entries;
+		end->mask = mask;
+		end->deny = richace_is_deny(ace);
+		end++;
+	}
+	qsort(entries, end - entries, sizeof(*entries), compile_entry_cmp);
+
+	/* Count the decisive entries and distinct users and groups. */
+	for (e = entries; e != end; e++) {
+		if (e == entries || e[-1].kind != e->kind || e[-1].id != e->id) {
+			seen = 0;
+			if (e->kind == COMPILE_USER)
+				n_users++;
+			else if (e->kind == COMPILE_UNIX_GROUP)
+				n_groups++;
+		}
+		if (e->mask & ~seen)
+			n_entries++;
+		seen |= e->mask;
+	}
+
+	size = sizeof(*compiled) +
+	       n_entries * sizeof(struct richacl_compiled_entry) +
+	       (n_users + n_groups) * sizeof(struct richacl_compiled_who);
+	compiled = malloc(size);
+	if (!compiled)
+		goto out;
+	memset(compiled, 0, size);
+	compiled->c_flags = acl->a_flags;
+	compiled->c_owner_mask = acl->a_owner_mask;
+	compiled->c_group_mask = acl->a_group_mask;
+	compiled->c_other_mask = acl->a_other_mask;
+	compiled->c_users = (void *)(compiled->c_entries + n_entries);
+	compiled->c_groups = compiled->c_users + n_users;
+
+	n_entries = 0;
+	for (e = entries; e != end; e++) {
+		if (e == entries || e[-1].kind != e->kind || e[-1].id != e->id) {
+			who = compiled_who(compiled, e->kind);
+			who->cw_id = e->id;
+			who->cw_first = n_entries;
+			seen = 0;
+		}
+		if (e->mask & ~seen) {
+			struct richacl_compiled_entry *entry =
+				compiled->c_entries + n_entries++;
+
+			entry->ce_pos = e->pos;
+			entry->ce_mask = e->mask & ~seen;
+			entry->ce_deny = e->deny;
+			who->cw_count++;
+		}
+		seen |= e->mask;
+	}
+
+	for (n = 0; n < 4; n++) {
+		struct richacl_decision decision = { };
+
+		if (n & RICHACL_FLAT_OWNER)
+			richacl_compiled_decide(compiled, &compiled->c_owner,
+						~0, &decision);
+		if (n & RICHACL_FLAT_GROUP)
+			richacl_compiled_decide(compiled, &compiled->c_group,
+						~0, &decision);
+		richacl_compiled_decide(compiled, &compiled->c_everyone,
+					~0, &decision);
+		compiled->c_flat_allowed[n] =
+			decision.d_decided & ~decision.d_denied;
+		compiled->c_flat_denied[n] = decision.d_denied;
+	}
+
+out:
+	free(entries);
+	return compiled;
+}
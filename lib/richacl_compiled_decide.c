@@ -0,0 +1,91 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <strings.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_compiled_lookup  -  find the entries of a user or group
+ * @whos:	user or group entries of a compiled acl, sorted by id
+ * @count:	number of entries in @whos
+ * @id:		user or group id to look up
+ *
+ * Returns NULL if @whos has no entry for @id.
+ */
+const struct richacl_compiled_who *
+richacl_compiled_lookup(const struct richacl_compiled_who *whos,
+			unsigned int count, id_t id)
+{
+	unsigned int lo = 0, hi = count;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (whos[mid].cw_id == id)
+			return whos + mid;
+		if (whos[mid].cw_id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+/**
+ * richacl_compiled_decide  -  merge the entries of a principal into a decision
+ * @compiled:	compiled acl
+ * @who:	principal which matches the process
+ * @mask:	mask flags we are interested in
+ * @decision:	decision so far
+ *
+ * In the original acl, the first matching entry which includes a mask flag
+ * decides whether that flag is allowed or denied.  Principals can be merged
+ * in any order: an entry only overrides an earlier decision when it comes
+ * before the deciding entry in the original acl.
+ */
+void
+richacl_compiled_decide(const struct richacl_compiled *compiled,
+			const struct richacl_compiled_who *who,
+			unsigned int mask, struct richacl_decision *decision)
+{
+	const struct richacl_compiled_entry *entry, *end;
+
+	entry = compiled->c_entries + who->cw_first;
+	end = entry + who->cw_count;
+	for (; entry != end; entry++) {
+		unsigned int bits = entry->ce_mask & mask;
+
+		while (bits) {
+			int n = ffs(bits) - 1;
+			unsigned int bit = 1U << n;
+
+			bits &= ~bit;
+			if ((decision->d_decided & bit) &&
+			    decision->d_pos[n] < entry->ce_pos)
+				continue;
+			decision->d_decided |= bit;
+			decision->d_pos[n] = entry->ce_pos;
+			if (entry->ce_deny)
+				decision->d_denied |= bit;
+			else
+				decision->d_denied &= ~bit;
+		}
+	}
+}
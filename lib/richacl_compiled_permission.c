@@ -0,0 +1,48 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_compiled_permission  -  check if a user has the requested access
+ * @compiled:	compiled ACL of the file to check
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @user:	User ID of the accessing process
+ * @groups:	Group IDs the accessing process is a member in
+ * @n_groups:	Number of entries in @groups
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ *
+ * Returns the same result as richacl_permission() on the acl @compiled
+ * was compiled from.
+ */
+bool richacl_compiled_permission(const struct richacl_compiled *compiled,
+				 uid_t owner, gid_t owning_group, uid_t user,
+				 const gid_t *groups, int n_groups,
+				 unsigned int mask)
+{
+	struct richacl_cred cred = {
+		.cr_uid = user,
+		.cr_groups = groups,
+		.cr_n_groups = n_groups,
+	};
+
+	return richacl_compiled_permission_cred(compiled, owner, owning_group,
+						&cred, mask);
+}
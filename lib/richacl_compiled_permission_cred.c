@@ -0,0 +1,116 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_compiled_permission_cred  -  check if a process has the requested access
+ * @compiled:	compiled ACL of the file to check
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @cred:	User and groups of the accessing process
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ *
+ * Returns the same result as richacl_permission_cred() on the acl @compiled
+ * was compiled from.  The cost is one lookup for the user, and one lookup
+ * for each group in @cred or each group entry in @compiled, whichever is
+ * smaller.  Processes which only match owner@, group@, or everyone@ entries
+ * do not need to look at any entries.
+ */
+bool richacl_compiled_permission_cred(const struct richacl_compiled *compiled,
+				      uid_t owner, gid_t owning_group,
+				      const struct richacl_cred *cred,
+				      unsigned int mask)
+{
+	const struct richacl_compiled_who *who;
+	struct richacl_decision decision;
+	struct richacl_eval ev;
+	unsigned int allowed, denied;
+	uid_t user = cred->cr_uid;
+	int in_owning_group = richacl_cred_in_group(cred, owning_group);
+	int matched = 0;
+	int n;
+
+	if (richacl_eval_init(&ev, compiled->c_flags, compiled->c_owner_mask,
+			      compiled->c_group_mask, compiled->c_other_mask,
+			      user == owner, in_owning_group, mask, mask))
+		goto out;
+
+	decision.d_decided = 0;
+	decision.d_denied = 0;
+	who = richacl_compiled_lookup(compiled->c_users,
+				      compiled->c_n_users, user);
+	if (who) {
+		richacl_compiled_decide(compiled, who, mask, &decision);
+		matched = 1;
+	}
+	if (cred->cr_sorted && compiled->c_n_groups < cred->cr_n_groups) {
+		for (n = 0; n < compiled->c_n_groups; n++) {
+			who = compiled->c_groups + n;
+			if (richacl_cred_in_group(cred, who->cw_id)) {
+				richacl_compiled_decide(compiled, who, mask,
+							&decision);
+				matched = 1;
+			}
+		}
+	} else if (compiled->c_n_groups) {
+		for (n = 0; n < cred->cr_n_groups; n++) {
+			who = richacl_compiled_lookup(compiled->c_groups,
+						      compiled->c_n_groups,
+						      cred->cr_groups[n]);
+			if (who) {
+				richacl_compiled_decide(compiled, who, mask,
+							&decision);
+				matched = 1;
+			}
+		}
+	}
+
+	if (matched) {
+		/* The process is in the owner or group file class. */
+		ev.ev_in_owner_or_group_class = true;
+
+		if (user == owner)
+			richacl_compiled_decide(compiled, &compiled->c_owner,
+						mask, &decision);
+		if (in_owning_group)
+			richacl_compiled_decide(compiled, &compiled->c_group,
+						mask, &decision);
+		richacl_compiled_decide(compiled, &compiled->c_everyone,
+					mask, &decision);
+		allowed = decision.d_decided & ~decision.d_denied;
+		denied = decision.d_denied;
+	} else {
+		n = (user == owner ? RICHACL_FLAT_OWNER : 0) |
+		    (in_owning_group ? RICHACL_FLAT_GROUP : 0);
+		allowed = compiled->c_flat_allowed[n];
+		denied = compiled->c_flat_denied[n];
+	}
+
+	/*
+	 * The entries have been merged out of order; the decision is the
+	 * same as after richacl_eval_entry() for each of them.
+	 */
+	ev.ev_allowed = allowed & mask;
+	ev.ev_denied = denied & mask;
+	ev.ev_undecided = mask & ~(allowed | denied);
+
+out:
+	return richacl_eval_granted(&ev);
+}
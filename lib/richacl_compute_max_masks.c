@@ -18,7 +18,38 @@
   <http://www.gnu.org/licenses/>.
 */
 
+#include <stdlib.h>
+#include <string.h>
 #include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * struct who_state  -  what the entries of one identifier decide
+ * @ace:	first entry with this identifier, or NULL for an unused slot
+ * @decided:	permissions decided by entries with this identifier before
+ *		any everyone@ entry decided them
+ * @allowed:	those of @decided which are allowed
+ */
+struct who_state {
+	const struct richace *ace;
+	unsigned int decided;
+	unsigned int allowed;
+};
+
+/* Enough for acls with up to 32 entries without allocating. */
+#define WHO_STATES_ON_STACK 64
+
+static struct who_state *who_state(struct who_state *states,
+				   unsigned int n_states,
+				   const struct richace *ace)
+{
+	unsigned int n = richace_identifier_hash(ace) & (n_states - 1);
+
+	while (states[n].ace && !richace_is_same_identifier(states[n].ace, ace))
+		n = (n + 1) & (n_states - 1);
+	states[n].ace = ace;
+	return &states[n];
+}
 
 /**
  * richacl_allowed_to_who  -  mask flags allowed to a specific who value
@@ -46,35 +77,115 @@ static unsigned int richacl_allowed_to_who(struct richacl *acl,
 	return allowed;
 }
 
-/**
- * richacl_group_class_allowed  -  maximum permissions the group class is allowed
- *
- * See richacl_compute_max_masks().
+/*
+ * Fallback for when the identifier states cannot be allocated: compute the
+ * permissions allowed to each group class entry separately.
  */
-static unsigned int richacl_group_class_allowed(struct richacl *acl)
+static unsigned int richacl_group_class_allowed_slow(struct richacl *acl)
 {
 	struct richace *ace;
 	unsigned int everyone_allowed = 0, group_class_allowed = 0;
 	int had_group_ace = 0;
 
 	richacl_for_each_entry_reverse(ace, acl) {
-		if (richace_is_inherit_only(ace) ||
-		    richace_is_owner(ace))
+		if (richace_is_inherit_only(ace))
 			continue;
 
-		if (richace_is_everyone(ace)) {
+		switch (richace_class(ace)) {
+		case RICHACE_CLASS_OWNER:
+			break;
+		case RICHACE_CLASS_EVERYONE:
 			if (richace_is_allow(ace))
 				everyone_allowed |= ace->e_mask;
 			else if (richace_is_deny(ace))
 				everyone_allowed &= ~ace->e_mask;
-		} else {
+			break;
+		case RICHACE_CLASS_GROUP:
+			had_group_ace = 1;
+			/* fall through */
+		default:
 			group_class_allowed |=
 				richacl_allowed_to_who(acl, ace);
+			break;
+		}
+	}
+	if (!had_group_ace)
+		group_class_allowed |= everyone_allowed;
+	return group_class_allowed;
+}
 
-			if (richace_is_group(ace))
-				had_group_ace = 1;
+/**
+ * richacl_group_class_allowed  -  maximum permissions the group class is allowed
+ *
+ * The group class is allowed the union of what richacl_allowed_to_who()
+ * returns for each identifier other than owner@ and everyone@.  That
+ * function goes through the entries in reverse order, so each permission
+ * ends up being decided by the first entry for the identifier or for
+ * everyone@ which includes it.  The result for all identifiers can thus be
+ * computed in a single pass in entry order, with the state of each
+ * identifier kept in a hash table.
+ *
+ * See richacl_compute_max_masks().
+ */
+static unsigned int richacl_group_class_allowed(struct richacl *acl)
+{
+	struct who_state states_on_stack[WHO_STATES_ON_STACK], *states;
+	unsigned int everyone_decided = 0, everyone_allowed = 0;
+	unsigned int group_class_allowed = 0;
+	unsigned int n_states = WHO_STATES_ON_STACK, n;
+	int had_group_ace = 0;
+	struct richace *ace;
+
+	while (n_states < 2 * acl->a_count)
+		n_states *= 2;
+	if (n_states == WHO_STATES_ON_STACK) {
+		states = states_on_stack;
+		memset(states, 0, sizeof(states_on_stack));
+	} else {
+		states = calloc(n_states, sizeof(*states));
+		if (!states)
+			return richacl_group_class_allowed_slow(acl);
+	}
+
+	richacl_for_each_entry(ace, acl) {
+		struct who_state *state;
+		unsigned int decided;
+
+		if (richace_is_inherit_only(ace))
+			continue;
+
+		switch (richace_class(ace)) {
+		case RICHACE_CLASS_OWNER:
+			break;
+		case RICHACE_CLASS_EVERYONE:
+			if (richace_is_allow(ace))
+				everyone_allowed |= ace->e_mask &
+						    ~everyone_decided;
+			if (richace_is_allow(ace) || richace_is_deny(ace))
+				everyone_decided |= ace->e_mask;
+			break;
+		case RICHACE_CLASS_GROUP:
+			had_group_ace = 1;
+			/* fall through */
+		default:
+			state = who_state(states, n_states, ace);
+			if (!(richace_is_allow(ace) || richace_is_deny(ace)))
+				break;
+			decided = ace->e_mask & ~(state->decided |
+						  everyone_decided);
+			if (richace_is_allow(ace))
+				state->allowed |= decided;
+			state->decided |= decided;
+			break;
 		}
 	}
+	for (n = 0; n < n_states; n++) {
+		if (states[n].ace)
+			group_class_allowed |= states[n].allowed |
+				(everyone_allowed & ~states[n].decided);
+	}
+	if (states != states_on_stack)
+		free(states);
 	if (!had_group_ace)
 		group_class_allowed |= everyone_allowed;
 	return group_class_allowed;
@@ -116,12 +227,14 @@ restart:
 		if (richace_is_inherit_only(ace))
 			continue;
 
-		if (richace_is_owner(ace)) {
+		switch (richace_class(ace)) {
+		case RICHACE_CLASS_OWNER:
 			if (richace_is_allow(ace))
 				acl->a_owner_mask |= ace->e_mask;
 			else if (richace_is_deny(ace))
 				acl->a_owner_mask &= ~ace->e_mask;
-		} else if (richace_is_everyone(ace)) {
+			break;
+		case RICHACE_CLASS_EVERYONE:
 			if (richace_is_allow(ace)) {
 				acl->a_owner_mask |= ace->e_mask;
 				acl->a_group_mask |= ace->e_mask & gmask;
@@ -131,7 +244,8 @@ restart:
 				acl->a_group_mask &= ~ace->e_mask;
 				acl->a_other_mask &= ~ace->e_mask;
 			}
-		} else {
+			break;
+		default:
 			if (richace_is_allow(ace)) {
 				acl->a_owner_mask |= ace->e_mask & gmask;
 				acl->a_group_mask |= ace->e_mask & gmask;
@@ -140,6 +254,7 @@ restart:
 				if (gmask != ~0)  /* should always be true */
 					goto restart;
 			}
+			break;
 		}
 	}
 
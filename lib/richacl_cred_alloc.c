@@ -0,0 +1,132 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/*
+ * Index the groups of credentials with at least this many groups in a
+ * bitmap, as long as the bitmap is not much bigger than the group array.
+ */
+#define RICHACL_CRED_BITMAP_MIN_GROUPS	16
+#define RICHACL_CRED_BITMAP_MAX_RATIO	16
+
+static unsigned long long richacl_cred_serial;
+
+static int gid_cmp(const void *a, const void *b)
+{
+	gid_t g1 = *(const gid_t *)a, g2 = *(const gid_t *)b;
+
+	return g1 < g2 ? -1 : g1 > g2;
+}
+
+/**
+ * richacl_cred_alloc  -  allocate the credentials of a process
+ * @user:	user the process runs as
+ * @groups:	groups the process is in
+ * @n_groups:	number of groups in @groups (or negative)
+ *
+ * If @n_groups is negative, the effective group and the supplementary groups
+ * of the calling process are used.  The groups are sorted and duplicates are
+ * removed, so that the credentials can be reused for any number of
+ * permission checks at a cost of O(1) or O(log n) per group lookup.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_cred *richacl_cred_alloc(uid_t user, const gid_t *groups,
+					int n_groups)
+{
+	struct richacl_cred *cred;
+	gid_t *sorted;
+	size_t bitmap_size = 0;
+	int n, count, process_groups = n_groups < 0;
+
+	if (process_groups) {
+		n_groups = getgroups(0, NULL);
+		if (n_groups < 0)
+			return NULL;
+		n_groups++;
+	}
+	cred = malloc(sizeof(*cred) + n_groups * sizeof(gid_t));
+	if (!cred)
+		return NULL;
+	sorted = (gid_t *)(cred + 1);
+	if (!process_groups)
+		memcpy(sorted, groups, n_groups * sizeof(gid_t));
+	else {
+		sorted[0] = getegid();
+		n = getgroups(n_groups - 1, sorted + 1);
+		if (n < 0) {
+			free(cred);
+			return NULL;
+		}
+		n_groups = n + 1;
+	}
+	qsort(sorted, n_groups, sizeof(gid_t), gid_cmp);
+	for (n = 0, count = 0; n < n_groups; n++) {
+		if (count && sorted[count - 1] == sorted[n])
+			continue;
+		sorted[count++] = sorted[n];
+	}
+
+	memset(cred, 0, sizeof(*cred));
+	cred->cr_uid = user;
+	cred->cr_n_groups = count;
+	cred->cr_groups = sorted;
+	cred->cr_sorted = 1;
+	cred->cr_serial = __atomic_add_fetch(&richacl_cred_serial, 1,
+					     __ATOMIC_RELAXED);
+
+	if (count >= RICHACL_CRED_BITMAP_MIN_GROUPS) {
+		gid_t range = sorted[count - 1] - sorted[0];
+
+		if (range / 8 + 1 <=
+		    count * sizeof(gid_t) * RICHACL_CRED_BITMAP_MAX_RATIO)
+			bitmap_size = range / 8 + 1;
+	}
+	if (bitmap_size) {
+		struct richacl_cred *cred2;
+		unsigned char *bitmap;
+		size_t size = sizeof(*cred) + count * sizeof(gid_t);
+
+		cred2 = realloc(cred, size + bitmap_size);
+		if (!cred2) {
+			free(cred);
+			return NULL;
+		}
+		cred = cred2;
+		sorted = (gid_t *)(cred + 1);
+		bitmap = (unsigned char *)cred + size;
+		memset(bitmap, 0, bitmap_size);
+		for (n = 0; n < count; n++) {
+			gid_t bit = sorted[n] - sorted[0];
+
+			bitmap[bit / 8] |= 1 << (bit % 8);
+		}
+		cred->cr_groups = sorted;
+		cred->cr_bitmap_base = sorted[0];
+		cred->cr_bitmap_bits = sorted[count - 1] - sorted[0] + 1;
+		cred->cr_bitmap = bitmap;
+	}
+	return cred;
+}
@@ -0,0 +1,199 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/stat.h>
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+static int id_cmp(const void *a, const void *b)
+{
+	id_t id1 = *(const id_t *)a, id2 = *(const id_t *)b;
+
+	return id1 < id2 ? -1 : id1 > id2;
+}
+
+/* Sort and deduplicate @ids, and return the number of distinct ids. */
+static unsigned int unique_ids(id_t *ids, unsigned int count)
+{
+	unsigned int n, m = 0;
+
+	qsort(ids, count, sizeof(*ids), id_cmp);
+	for (n = 0; n < count; n++) {
+		if (m == 0 || ids[m - 1] != ids[n])
+			ids[m++] = ids[n];
+	}
+	return m;
+}
+
+/* Find the row for @id among the @count rows starting at @first. */
+static unsigned int find_row(const struct richacl_effective *matrix,
+			     unsigned int first, unsigned int count, id_t id)
+{
+	unsigned int lo = first, hi = first + count;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (matrix[mid].e_id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * richacl_effective  -  compute the permissions of all principals in an acl
+ * @acl:	acl of the file
+ * @st:		status of the file
+ * @count:	number of rows returned
+ *
+ * Returns an array of rows for the file owner, each user named in @acl in
+ * increasing order of user id, the owning group, each group named in @acl
+ * in increasing order of group id, and everyone else, in that order.  The
+ * mask of each row is what richacl_access() would return for a process
+ * which only matches that principal: for example, the row of a group is
+ * for a process which is neither the owner nor a named user, and which is
+ * in no other group than that one.  The rows of named principals which are
+ * also the owner or owning group repeat the owner or owning group row.
+ *
+ * All rows are computed in a single pass over the entries of @acl.  Returns
+ * NULL and sets errno on error; the caller must free() the result.
+ */
+struct richacl_effective *richacl_effective(const struct richacl *acl,
+					    const struct stat *st,
+					    unsigned int *count)
+{
+	const struct richace *ace;
+	struct richacl_effective *matrix;
+	struct richacl_eval *state;
+	unsigned int n_users = 0, n_groups = 0, n, rows;
+	unsigned int owner, group, everyone;
+	id_t *ids;
+
+	ids = malloc(sizeof(*ids) * (acl->a_count + 1));
+	if (!ids)
+		return NULL;
+	richacl_for_each_entry(ace, acl) {
+		if (richace_class(ace) == RICHACE_CLASS_UID)
+			ids[n_users++] = ace->e_id;
+	}
+	n_users = unique_ids(ids, n_users);
+	richacl_for_each_entry(ace, acl) {
+		if (richace_class(ace) == RICHACE_CLASS_GID)
+			ids[n_users + n_groups++] = ace->e_id;
+	}
+	n_groups = unique_ids(ids + n_users, n_groups);
+
+	owner = 0;
+	group = 1 + n_users;
+	everyone = group + 1 + n_groups;
+	rows = everyone + 1;
+	matrix = malloc(sizeof(*matrix) * rows + sizeof(*state) * rows);
+	if (!matrix) {
+		free(ids);
+		return NULL;
+	}
+	state = (struct richacl_eval *)(matrix + rows);
+
+	matrix[owner].e_flags = RICHACE_SPECIAL_WHO;
+	matrix[owner].e_id = RICHACE_OWNER_SPECIAL_ID;
+	for (n = 0; n < n_users; n++) {
+		matrix[owner + 1 + n].e_flags = 0;
+		matrix[owner + 1 + n].e_id = ids[n];
+	}
+	matrix[group].e_flags = RICHACE_SPECIAL_WHO;
+	matrix[group].e_id = RICHACE_GROUP_SPECIAL_ID;
+	for (n = 0; n < n_groups; n++) {
+		matrix[group + 1 + n].e_flags = RICHACE_IDENTIFIER_GROUP;
+		matrix[group + 1 + n].e_id = ids[n_users + n];
+	}
+	matrix[everyone].e_flags = RICHACE_SPECIAL_WHO;
+	matrix[everyone].e_id = RICHACE_EVERYONE_SPECIAL_ID;
+	free(ids);
+
+	/* The owning group row is in the group file class by definition. */
+	for (n = 0; n < rows; n++)
+		richacl_eval_init(&state[n], acl->a_flags, acl->a_owner_mask,
+				  acl->a_group_mask, acl->a_other_mask,
+				  n == owner, n == group, RICHACE_VALID_MASK, 0);
+
+	/*
+	 * Named users which are also the owner share the owner row, and named
+	 * groups which are also the owning group share the owning group row;
+	 * those rows are filled in at the end.  Everyone@ entries apply to
+	 * all rows; any other entry applies to a single row.
+	 */
+	richacl_for_each_entry(ace, acl) {
+		unsigned int class = richace_class(ace);
+		unsigned int row;
+
+		if (richace_is_inherit_only(ace))
+			continue;
+		switch (class) {
+		case RICHACE_CLASS_EVERYONE:
+			for (n = 0; n < rows; n++)
+				richacl_eval_entry(&state[n], class,
+						   ace->e_type, ace->e_mask);
+			continue;
+		case RICHACE_CLASS_OWNER:
+			row = owner;
+			break;
+		case RICHACE_CLASS_UID:
+			if (ace->e_id == st->st_uid)
+				row = owner;
+			else
+				row = find_row(matrix, owner + 1, n_users,
+					       ace->e_id);
+			break;
+		case RICHACE_CLASS_GROUP:
+			row = group;
+			break;
+		case RICHACE_CLASS_GID:
+			if (ace->e_id == st->st_gid)
+				row = group;
+			else
+				row = find_row(matrix, group + 1, n_groups,
+					       ace->e_id);
+			break;
+		default:
+			continue;
+		}
+
+		richacl_eval_entry(&state[row], class, ace->e_type,
+				   ace->e_mask);
+	}
+
+	for (n = 0; n < rows; n++)
+		matrix[n].e_mask = richacl_eval_mask(&state[n]);
+	for (n = 0; n < rows; n++) {
+		struct richacl_effective *row = &matrix[n];
+
+		if (n > owner && n < group && row->e_id == st->st_uid)
+			row->e_mask = matrix[owner].e_mask;
+		else if (n > group && n < everyone && row->e_id == st->st_gid)
+			row->e_mask = matrix[group].e_mask;
+		/* RICHACE_DELETE_CHILD is meaningless for non-directories. */
+		if (!S_ISDIR(st->st_mode))
+			row->e_mask &= ~RICHACE_DELETE_CHILD;
+	}
+
+	*count = rows;
+	return matrix;
+}
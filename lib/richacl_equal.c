@@ -0,0 +1,62 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <string.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+_Static_assert(offsetof(struct richace, e_id) ==
+	       sizeof(unsigned short) * 2 + sizeof(unsigned int),
+	       "struct richace has padding");
+
+/**
+ * richacl_equal  -  check if two acls are identical
+ *
+ * Entries with unmapped identifiers are compared by identifier.  Callers
+ * which keep the richacl_hash() of their acls, such as lookup tables,
+ * should compare the hashes first: acls with different hashes are never
+ * identical.
+ */
+bool richacl_equal(const struct richacl *acl1, const struct richacl *acl2)
+{
+	unsigned int n;
+
+	if (acl1 == acl2)
+		return true;
+	if (acl1->a_flags != acl2->a_flags ||
+	    acl1->a_count != acl2->a_count ||
+	    acl1->a_owner_mask != acl2->a_owner_mask ||
+	    acl1->a_group_mask != acl2->a_group_mask ||
+	    acl1->a_other_mask != acl2->a_other_mask)
+		return false;
+	for (n = 0; n < acl1->a_count; n++) {
+		const struct richace *ace1 = &acl1->a_entries[n];
+		const struct richace *ace2 = &acl2->a_entries[n];
+
+		/* The type, flags, and mask are stored without padding. */
+		if (memcmp(ace1, ace2, offsetof(struct richace, e_id)))
+			return false;
+		if (ace1->e_flags & RICHACE_UNMAPPED_WHO) {
+			if (strcmp(ace1->e_who, ace2->e_who))
+				return false;
+		} else if (ace1->e_id != ace2->e_id)
+			return false;
+	}
+	return true;
+}
@@ -27,14 +27,18 @@
 #include "richacl-internal.h"
 #include "byteorder.h"
 
-struct richacl *richacl_from_xattr(const void *value, size_t size)
+/**
+ * richacl_xattr_count  -  check the header of an xattr value
+ * @value:	xattr value
+ * @size:	size of @value
+ *
+ * Returns the number of entries in @value, or -1 with errno set to EINVAL
+ * if @value is not a valid richacl xattr.
+ */
+int richacl_xattr_count(const void *value, size_t size)
 {
 	const struct richacl_xattr *xattr_acl = value;
-	const struct richace_xattr *xattr_ace = (void *)(xattr_acl + 1);
-	struct richacl *acl = NULL;
-	struct richace *ace;
 	unsigned int count;
-	char *xattr_ids;
 
 	if (size < sizeof(*xattr_acl) ||
 	    xattr_acl->a_version != RICHACL_XATTR_VERSION)
@@ -43,57 +47,221 @@ struct richacl *richacl_from_xattr(const void *value, size_t size)
 	count = le16_to_cpu(xattr_acl->a_count);
 	if (count > RICHACL_XATTR_MAX_COUNT)
 		goto fail_einval;
-	if (size < count * sizeof(*xattr_ace))
+	if (size < count * sizeof(struct richace_xattr))
 		goto fail_einval;
-	size -= count * sizeof(*xattr_ace);
+	return count;
 
-	acl = richacl_alloc(count);
-	if (!acl)
-		return NULL;
+fail_einval:
+	errno = EINVAL;
+	return -1;
+}
 
-	acl->a_flags = xattr_acl->a_flags;
-	acl->a_owner_mask = le32_to_cpu(xattr_acl->a_owner_mask);
-	acl->a_group_mask = le32_to_cpu(xattr_acl->a_group_mask);
-	acl->a_other_mask = le32_to_cpu(xattr_acl->a_other_mask);
+/**
+ * richacl_xattr_decode  -  decode an xattr value
+ * @acl:	acl with room for richacl_xattr_count(@value, @size) entries
+ * @value:	xattr value
+ * @size:	size of @value
+ *
+ * The e_who fields of unmapped entries in @acl point into @value, so @acl
+ * must not be passed to richacl_free() or used after @value goes away.
+ *
+ * Returns the number of entries with an unmapped identifier, or -1 with
+ * errno set to EINVAL if @value is not a valid richacl xattr.
+ */
+int richacl_xattr_decode(struct richacl *acl, const void *value, size_t size)
+{
+	const struct richacl_xattr *xattr_acl = value;
+	const struct richace_xattr *xattr_ace = (void *)(xattr_acl + 1);
+	struct richace *ace;
+	int count, unmapped;
+	char *xattr_ids;
 
+	count = richacl_xattr_count(value, size);
+	if (count < 0)
+		return -1;
+	unmapped = richacl_xattr_decode_entries(acl->a_entries, xattr_ace,
+						count);
+	if (unmapped < 0)
+		return -1;
+	size -= sizeof(*xattr_acl) + count * sizeof(*xattr_ace);
+
+	/*
+	 * The unmapped identifiers must fill the rest of @value exactly, one
+	 * null-terminated string per entry with an unmapped identifier.
+	 */
 	xattr_ids = (char *)(xattr_ace + count);
 	if (size) {
+		unsigned int strings = 0;
+		size_t n;
+
 		if (xattr_ids[size - 1] != 0)
 			goto fail_einval;
+		for (n = 0; n < size; n++)
+			strings += !xattr_ids[n];
+		if (strings != unmapped)
+			goto fail_einval;
+	} else if (unmapped)
+		goto fail_einval;
+
+	acl->a_count = count;
+	acl->a_flags = xattr_acl->a_flags;
+	acl->a_owner_mask = le32_to_cpu(xattr_acl->a_owner_mask);
+	acl->a_group_mask = le32_to_cpu(xattr_acl->a_group_mask);
+	acl->a_other_mask = le32_to_cpu(xattr_acl->a_other_mask);
+	if (unmapped) {
+		richacl_for_each_entry(ace, acl) {
+			if (ace->e_flags & RICHACE_UNMAPPED_WHO) {
+				ace->e_who = xattr_ids;
+				xattr_ids += strlen(xattr_ids) + 1;
+			}
+		}
 	}
+	return unmapped;
+
+fail_einval:
+	errno = EINVAL;
+	return -1;
+}
+
+/**
+ * richacl_xattr_decoded_size  -  size of an acl decoded from an xattr value
+ * @value:	xattr value
+ * @size:	size of @value
+ *
+ * Returns the size of the buffer richacl_from_xattr_buffer() needs for
+ * decoding @value, including the unmapped identifiers, or 0 with errno set
+ * to EINVAL if @value is not a valid richacl xattr.
+ */
+size_t richacl_xattr_decoded_size(const void *value, size_t size)
+{
+	const struct richacl_xattr *xattr_acl = value;
+	const struct richace_xattr *xattr_ace = (void *)(xattr_acl + 1);
+	size_t ids_size;
+	int count;
+
+	count = richacl_xattr_count(value, size);
+	if (count < 0)
+		return 0;
+	ids_size = size - sizeof(*xattr_acl) - count * sizeof(*xattr_ace);
+	return sizeof(struct richacl) + count * sizeof(struct richace) +
+	       ids_size;
+}
+
+/**
+ * richacl_from_xattr_buffer  -  decode an xattr value into a caller buffer
+ * @value:	xattr value
+ * @size:	size of @value
+ * @buffer:	buffer suitably aligned for a struct richacl
+ * @buffer_size: size of @buffer, at least richacl_xattr_decoded_size()
+ *
+ * Decodes @value into @buffer, with the unmapped identifiers stored after
+ * the entries, so that @value is not needed anymore afterwards.  The acl
+ * belongs to the caller: it must not be passed to richacl_free() or to any
+ * function that adds entries, like richacl_apply_masks(); use
+ * richacl_clone() to get an acl for that.
+ *
+ * Returns the acl (at the start of @buffer), or NULL with errno set to
+ * EINVAL if @value is not a valid richacl xattr, or to ERANGE if @buffer
+ * is too small.
+ */
+struct richacl *richacl_from_xattr_buffer(const void *value, size_t size,
+					  void *buffer, size_t buffer_size)
+{
+	struct richacl *acl = buffer;
+	struct richace *ace;
+	size_t decoded_size;
+	char *ids;
+	int count, unmapped;
+
+	decoded_size = richacl_xattr_decoded_size(value, size);
+	if (!decoded_size)
+		return NULL;
+	if (buffer_size < decoded_size) {
+		errno = ERANGE;
+		return NULL;
+	}
+	count = richacl_xattr_count(value, size);
+	memset(acl, 0, sizeof(*acl) + count * sizeof(struct richace));
+	unmapped = richacl_xattr_decode(acl, value, size);
+	if (unmapped <= 0)
+		return unmapped ? NULL : acl;
+
+	ids = (char *)(acl->a_entries + count);
 	richacl_for_each_entry(ace, acl) {
-		ace->e_type  = le16_to_cpu(xattr_ace->e_type);
-		ace->e_flags = le16_to_cpu(xattr_ace->e_flags);
-		ace->e_mask  = le32_to_cpu(xattr_ace->e_mask);
-		ace->e_id    = le32_to_cpu(xattr_ace->e_id);
-		if (ace->e_flags & RICHACE_SPECIAL_WHO &&
-		    ace->e_id > RICHACE_EVERYONE_SPECIAL_ID)
-			goto fail_einval;
 		if (ace->e_flags & RICHACE_UNMAPPED_WHO) {
-			size_t sz;
-			if (!size)
-				goto fail_einval;
-			sz = strlen(xattr_ids) + 1;
-			ace->e_who = malloc(sz);
-			if (!ace->e_who) {
-				richacl_free(acl);
-				errno = ENOMEM;
-				return NULL;
-			}
-			memcpy(ace->e_who, xattr_ids, sz);
-			xattr_ids += sz;
-			size -= sz;
+			size_t len = strlen(ace->e_who) + 1;
+
+			memcpy(ids, ace->e_who, len);
+			ace->e_who = ids;
+			ids += len;
 		}
-		xattr_ace++;
 	}
+	return acl;
+}
 
-	if (size != 0)
-		goto fail_einval;
+/*
+ * Decode the xattr value of @len bytes at the start of @buffer into the
+ * remaining space in @buffer, which is @size bytes big.
+ */
+struct richacl *richacl_from_xattr_behind(void *buffer, size_t len,
+					  size_t size)
+{
+	uintptr_t start = ALIGN((uintptr_t)buffer + len, sizeof(void *));
+	uintptr_t end = (uintptr_t)buffer + size;
 
+	if (start > end) {
+		errno = ERANGE;
+		return NULL;
+	}
+	return richacl_from_xattr_buffer(buffer, len, (void *)start,
+					 end - start);
+}
+
+/**
+ * richacl_from_xattr  -  decode an xattr value
+ * @value:	xattr value
+ * @size:	size of @value
+ *
+ * The entries are decoded into a single allocation; each unmapped
+ * identifier is allocated separately, as richacl_free() expects.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl *richacl_from_xattr(const void *value, size_t size)
+{
+	struct richacl *acl;
+	struct richace *ace;
+	int count, unmapped;
+
+	count = richacl_xattr_count(value, size);
+	if (count < 0)
+		return NULL;
+	acl = richacl_alloc(count);
+	if (!acl)
+		return NULL;
+	unmapped = richacl_xattr_decode(acl, value, size);
+	if (unmapped < 0) {
+		free(acl);
+		return NULL;
+	}
+	if (unmapped) {
+		richacl_for_each_entry(ace, acl) {
+			if (!(ace->e_flags & RICHACE_UNMAPPED_WHO))
+				continue;
+			ace->e_who = strdup(ace->e_who);
+			if (!ace->e_who)
+				goto fail;
+		}
+	}
 	return acl;
 
-fail_einval:
-	richacl_free(acl);
-	errno = EINVAL;
+fail:
+	/* The identifiers after @ace still point into @value. */
+	while (ace != acl->a_entries) {
+		ace--;
+		if (ace->e_flags & RICHACE_UNMAPPED_WHO)
+			free(ace->e_who);
+	}
+	free(acl);
 	return NULL;
 }
@@ -0,0 +1,61 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_get_at  -  get the acl of a file relative to a directory
+ * @dirfd:	directory file descriptor, or AT_FDCWD
+ * @name:	file name relative to @dirfd, or "" with AT_EMPTY_PATH
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ *
+ * Like richacl_get_file(), but resolves @name like openat() and friends.
+ * Uses the getxattrat() system call where available.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl *richacl_get_at(int dirfd, const char *name, int flags)
+{
+	unsigned long buffer[RICHACL_ACCESS_BUFFER_SIZE / sizeof(unsigned long)];
+	void *value = buffer, *heap = NULL;
+	ssize_t retval;
+	struct richacl *acl = NULL;
+
+	retval = richacl_getxattr_at(dirfd, name, flags, value, sizeof(buffer));
+	while (retval < 0 && errno == ERANGE) {
+		/* The acl does not fit, or it has grown in the meantime. */
+		retval = richacl_getxattr_at(dirfd, name, flags, NULL, 0);
+		if (retval <= 0)
+			break;
+		free(heap);
+		heap = malloc(retval);
+		if (!heap)
+			return NULL;
+		value = heap;
+		retval = richacl_getxattr_at(dirfd, name, flags, value, retval);
+	}
+	if (retval > 0)
+		acl = richacl_from_xattr(value, retval);
+	free(heap);
+
+	return acl;
+}
@@ -19,28 +19,43 @@
 */
 
 #include <stdlib.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/xattr.h>
 #include <linux/xattr.h>
 #include "sys/richacl.h"
 
+/**
+ * richacl_get_fd  -  get the acl of an open file
+ *
+ * The acl is read into a buffer on the stack first, so that typical acls
+ * take a single fgetxattr() call; only bigger acls are sized first.
+ *
+ * Returns NULL and sets errno on error.
+ */
 struct richacl *richacl_get_fd(int fd)
 {
-	void *value;
+	unsigned long buffer[RICHACL_ACCESS_BUFFER_SIZE / sizeof(unsigned long)];
+	void *value = buffer, *heap = NULL;
 	ssize_t retval;
-	struct richacl *acl;
-
-	retval = fgetxattr(fd, XATTR_NAME_RICHACL, NULL, 0);
-	if (retval <= 0)
-		return NULL;
-
-	value = alloca(retval);
-	if (!value)
-		return NULL;
-	retval = fgetxattr(fd, XATTR_NAME_RICHACL, value, retval);
-	if (retval < 0)
-		return NULL;
-	acl = richacl_from_xattr(value, retval);
+	struct richacl *acl = NULL;
+
+	retval = fgetxattr(fd, XATTR_NAME_RICHACL, value, sizeof(buffer));
+	while (retval < 0 && errno == ERANGE) {
+		/* The acl does not fit, or it has grown in the meantime. */
+		retval = fgetxattr(fd, XATTR_NAME_RICHACL, NULL, 0);
+		if (retval <= 0)
+			break;
+		free(heap);
+		heap = malloc(retval);
+		if (!heap)
+			return NULL;
+		value = heap;
+		retval = fgetxattr(fd, XATTR_NAME_RICHACL, value, retval);
+	}
+	if (retval > 0)
+		acl = richacl_from_xattr(value, retval);
+	free(heap);
 
 	return acl;
 }
@@ -0,0 +1,48 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/types.h>
+#include <sys/xattr.h>
+#include <linux/xattr.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_get_file_buffer  -  get the acl of a file without allocating memory
+ * @path:	file name
+ * @buffer:	buffer suitably aligned for a struct richacl
+ * @size:	size of @buffer
+ *
+ * Reads the acl into @buffer with a single getxattr() call and decodes
+ * it there, so that @buffer can be reused for one file after the other.
+ * When @buffer is too small for the xattr value and the decoded acl, fails
+ * with errno set to ERANGE; richacl_get_file() can be used for those acls.
+ * The acl lives in @buffer; it must not be passed to richacl_free() or to
+ * any function that adds entries (see richacl_from_xattr_buffer()).
+ *
+ * Returns the acl, or NULL with errno set.
+ */
+struct richacl *richacl_get_file_buffer(const char *path, void *buffer, size_t size)
+{
+	ssize_t len;
+
+	len = getxattr(path, XATTR_NAME_RICHACL, buffer, size);
+	if (len <= 0)
+		return NULL;
+	return richacl_from_xattr_behind(buffer, len, size);
+}
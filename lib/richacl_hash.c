@@ -0,0 +1,49 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_hash  -  content hash of an acl
+ *
+ * The hash covers the acl flags, the file masks, and the type, flags, mask,
+ * and identifier of each entry; unmapped identifiers are hashed by value.
+ * It does not depend on where the acl is stored, so it can be kept on disk
+ * or compared between processes.  Acls which richacl_equal() considers
+ * identical have the same hash.  richacl_packed_hash() of the packed acl
+ * and richacl_xattr_hash() of the encoded acl are the same.
+ */
+uint64_t richacl_hash(const struct richacl *acl)
+{
+	const struct richace *ace;
+	uint64_t hash;
+
+	hash = richacl_hash_header(acl->a_flags, acl->a_count,
+				   acl->a_owner_mask, acl->a_group_mask,
+				   acl->a_other_mask);
+	richacl_for_each_entry(ace, acl) {
+		const char *who = NULL;
+
+		if (ace->e_flags & RICHACE_UNMAPPED_WHO)
+			who = ace->e_who;
+		hash = richacl_hash_entry(hash, ace->e_type, ace->e_flags,
+					  ace->e_mask, ace->e_id, who);
+	}
+	return hash;
+}
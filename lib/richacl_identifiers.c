@@ -0,0 +1,65 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_identifiers  -  find the entries with the same identifier
+ * @acl:	acl to look at
+ * @first:	array of @acl->a_count elements
+ *
+ * Set @first[n] to the index of the first entry in @acl with the same
+ * identifier as entry n (see richace_is_same_identifier()).  State for
+ * each identifier can then be kept in arrays indexed by @first[n] instead
+ * of going through the acl once per identifier.
+ */
+int
+richacl_identifiers(const struct richacl *acl, unsigned int *first)
+{
+	unsigned int n_slots = 16, slots_on_stack[64], *slots, n;
+
+	while (n_slots < 2 * acl->a_count)
+		n_slots *= 2;
+	/* Each slot contains the index of an entry plus one, or zero. */
+	if (n_slots <= 64) {
+		slots = slots_on_stack;
+		memset(slots, 0, n_slots * sizeof(*slots));
+	} else {
+		slots = calloc(n_slots, sizeof(*slots));
+		if (!slots)
+			return -1;
+	}
+	for (n = 0; n < acl->a_count; n++) {
+		const struct richace *ace = acl->a_entries + n;
+		unsigned int slot = richace_identifier_hash(ace) & (n_slots - 1);
+
+		while (slots[slot] &&
+		       !richace_is_same_identifier(
+				acl->a_entries + slots[slot] - 1, ace))
+			slot = (slot + 1) & (n_slots - 1);
+		if (!slots[slot])
+			slots[slot] = n + 1;
+		first[n] = slots[slot] - 1;
+	}
+	if (slots != slots_on_stack)
+		free(slots);
+	return 0;
+}
@@ -18,7 +18,6 @@
   <http://www.gnu.org/licenses/>.
 */
 
-#include <stdlib.h>
 #include <string.h>
 #include "sys/richacl.h"
 #include "richacl-internal.h"
@@ -29,25 +28,16 @@
  * @ace:	entry before which the new entry shall be inserted
  *
  * Insert a new entry in @alloc->acl at position @ace, and zero-initialize
- * it.  This may require reallocating @alloc->acl.
+ * it.  This may require reallocating @alloc->acl (see richacl_reserve()).
  */
 int
 richacl_insert_entry(struct richacl_alloc *alloc, struct richace **ace)
 {
 	int n = *ace - alloc->acl->a_entries;
 
-	if (alloc->count == alloc->acl->a_count) {
-		size_t size = sizeof(struct richacl) +
-			      (alloc->count + 1) * sizeof(struct richace);
-		struct richacl *acl2;
-
-		acl2 = realloc(alloc->acl, size);
-		if (!acl2)
-			return -1;
-		alloc->count++;
-		alloc->acl = acl2;
-		*ace = acl2->a_entries + n;
-	}
+	if (richacl_reserve(alloc, alloc->acl->a_count + 1))
+		return -1;
+	*ace = alloc->acl->a_entries + n;
 	memmove(*ace + 1, *ace, sizeof(struct richace) * (alloc->acl->a_count - n));
 	memset(*ace, 0, sizeof(struct richace));
 	alloc->acl->a_count++;
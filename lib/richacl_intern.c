@@ -0,0 +1,147 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/* Copy @acl and its unmapped identifiers into a single allocation. */
+static struct richacl_interned *intern_copy(const struct richacl *acl)
+{
+	size_t size = sizeof(struct richacl_interned) + sizeof(struct richacl) +
+		      acl->a_count * sizeof(struct richace);
+	struct richacl_interned *i;
+	const struct richace *ace;
+	struct richace *ace2;
+	struct richacl *copy;
+	char *ids;
+
+	richacl_for_each_entry(ace, acl) {
+		if (ace->e_flags & RICHACE_UNMAPPED_WHO)
+			size += strlen(ace->e_who) + 1;
+	}
+	i = malloc(size);
+	if (!i)
+		return NULL;
+	copy = richacl_interned_acl(i);
+	memcpy(copy, acl, sizeof(struct richacl) +
+			  acl->a_count * sizeof(struct richace));
+	ids = (char *)(copy->a_entries + copy->a_count);
+	richacl_for_each_entry(ace2, copy) {
+		if (ace2->e_flags & RICHACE_UNMAPPED_WHO) {
+			size_t len = strlen(ace2->e_who) + 1;
+
+			memcpy(ids, ace2->e_who, len);
+			ace2->e_who = ids;
+			ids += len;
+		}
+	}
+	return i;
+}
+
+static int grow_buckets(struct richacl_store_shard *shard)
+{
+	unsigned int n_buckets = shard->ss_n_buckets ?
+				 shard->ss_n_buckets * 2 : 16;
+	struct richacl_interned **buckets;
+	unsigned int b;
+
+	buckets = calloc(n_buckets, sizeof(*buckets));
+	if (!buckets)
+		return -1;
+	for (b = 0; b < shard->ss_n_buckets; b++) {
+		struct richacl_interned *i, *next;
+
+		for (i = shard->ss_buckets[b]; i; i = next) {
+			struct richacl_interned **head =
+				&buckets[i->i_hash & (n_buckets - 1)];
+
+			next = i->i_next;
+			i->i_next = *head;
+			*head = i;
+		}
+	}
+	free(shard->ss_buckets);
+	shard->ss_buckets = buckets;
+	shard->ss_n_buckets = n_buckets;
+	return 0;
+}
+
+/**
+ * richacl_intern  -  get the shared copy of an acl
+ * @store:	store from richacl_store_alloc()
+ * @acl:	acl to look up
+ *
+ * Looks up an acl identical to @acl (see richacl_equal()) in @store, and
+ * adds a copy of @acl to @store if there is none.  The shared acl must not
+ * be modified: to change it, make a private copy with richacl_clone(),
+ * change the copy, intern the copy, and drop the reference to the shared
+ * acl.  Acls from the same store are identical exactly when they are the
+ * same pointer.
+ *
+ * Returns the shared acl with a new reference, which is dropped with
+ * richacl_intern_put(), or NULL with errno set on error.
+ */
+const struct richacl *richacl_intern(struct richacl_store *store,
+				     const struct richacl *acl)
+{
+	uint64_t hash = richacl_hash(acl);
+	struct richacl_store_shard *shard = richacl_store_shard(store, hash);
+	struct richacl_interned *i, **head;
+
+	pthread_mutex_lock(&shard->ss_lock);
+	if (shard->ss_n_buckets) {
+		head = &shard->ss_buckets[hash & (shard->ss_n_buckets - 1)];
+		for (i = *head; i; i = i->i_next) {
+			if (i->i_hash == hash &&
+			    richacl_equal(richacl_interned_acl(i), acl)) {
+				__atomic_fetch_add(&i->i_refcount, 1,
+						   __ATOMIC_RELAXED);
+				pthread_mutex_unlock(&shard->ss_lock);
+				__atomic_fetch_add(&store->s_hits, 1,
+						   __ATOMIC_RELAXED);
+				return richacl_interned_acl(i);
+			}
+		}
+	}
+
+	/* Keep the buckets short; a table that cannot grow still works. */
+	if (shard->ss_count >= shard->ss_n_buckets &&
+	    grow_buckets(shard) && !shard->ss_n_buckets)
+		goto fail;
+	i = intern_copy(acl);
+	if (!i)
+		goto fail;
+	i->i_store = store;
+	i->i_hash = hash;
+	i->i_refcount = 1;
+	head = &shard->ss_buckets[hash & (shard->ss_n_buckets - 1)];
+	i->i_next = *head;
+	*head = i;
+	shard->ss_count++;
+	pthread_mutex_unlock(&shard->ss_lock);
+	__atomic_fetch_add(&store->s_misses, 1, __ATOMIC_RELAXED);
+	return richacl_interned_acl(i);
+
+fail:
+	pthread_mutex_unlock(&shard->ss_lock);
+	errno = ENOMEM;
+	return NULL;
+}
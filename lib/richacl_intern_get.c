@@ -0,0 +1,35 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_intern_get  -  take another reference to a shared acl
+ * @acl:	acl from richacl_intern()
+ *
+ * Returns @acl.  Each reference is dropped with richacl_intern_put().
+ */
+const struct richacl *richacl_intern_get(const struct richacl *acl)
+{
+	struct richacl_interned *i = richacl_acl_interned(acl);
+
+	/* The caller holds a reference, so the acl cannot go away. */
+	__atomic_fetch_add(&i->i_refcount, 1, __ATOMIC_RELAXED);
+	return acl;
+}
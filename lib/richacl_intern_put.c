@@ -0,0 +1,55 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_intern_put  -  drop a reference to a shared acl
+ * @acl:	acl from richacl_intern(), or NULL
+ *
+ * The acl is removed from its store when the last reference is dropped.
+ */
+void richacl_intern_put(const struct richacl *acl)
+{
+	struct richacl_interned *i, **pprev;
+	struct richacl_store_shard *shard;
+
+	if (!acl)
+		return;
+	i = richacl_acl_interned(acl);
+	shard = richacl_store_shard(i->i_store, i->i_hash);
+
+	/*
+	 * Drop the reference under the shard lock so that richacl_intern()
+	 * cannot find the acl and take a new reference while it goes away.
+	 */
+	pthread_mutex_lock(&shard->ss_lock);
+	if (__atomic_sub_fetch(&i->i_refcount, 1, __ATOMIC_ACQ_REL)) {
+		pthread_mutex_unlock(&shard->ss_lock);
+		return;
+	}
+	pprev = &shard->ss_buckets[i->i_hash & (shard->ss_n_buckets - 1)];
+	while (*pprev != i)
+		pprev = &(*pprev)->i_next;
+	*pprev = i->i_next;
+	shard->ss_count--;
+	pthread_mutex_unlock(&shard->ss_lock);
+	free(i);
+}
@@ -0,0 +1,59 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_masks_cache_alloc  -  allocate a cache of richacl_apply_masks() results
+ * @store:	store from richacl_store_alloc() for the acls and results
+ * @size:	maximum number of results to remember
+ *
+ * The cache remembers the results of richacl_apply_masks_cache() for acls
+ * with the same contents and the same file owner, so that applying the
+ * masks to many files with identical acls costs about one computation per
+ * distinct acl.  When the cache is full, the least recently used results
+ * are replaced.  The cache can be shared between threads; @store must be
+ * freed after the cache.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_masks_cache *
+richacl_masks_cache_alloc(struct richacl_store *store, unsigned int size)
+{
+	struct richacl_masks_cache *cache;
+	unsigned int n_sets;
+
+	n_sets = (size + RICHACL_CACHE_WAYS - 1) / RICHACL_CACHE_WAYS;
+	if (!n_sets)
+		n_sets = 1;
+	cache = calloc(1, sizeof(*cache) + n_sets * RICHACL_CACHE_WAYS *
+			  sizeof(struct richacl_masks_cache_entry));
+	if (!cache)
+		return NULL;
+	errno = pthread_mutex_init(&cache->mc_lock, NULL);
+	if (errno) {
+		free(cache);
+		return NULL;
+	}
+	cache->mc_store = store;
+	cache->mc_n_sets = n_sets;
+	return cache;
+}
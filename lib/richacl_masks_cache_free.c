@@ -0,0 +1,41 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_masks_cache_free  -  free a cache returned by richacl_masks_cache_alloc()
+ *
+ * The results returned by richacl_apply_masks_cache() remain valid until
+ * their references are dropped.
+ */
+void richacl_masks_cache_free(struct richacl_masks_cache *cache)
+{
+	unsigned int n;
+
+	if (!cache)
+		return;
+	for (n = 0; n < cache->mc_n_sets * RICHACL_CACHE_WAYS; n++) {
+		richacl_intern_put(cache->mc_entries[n].me_acl);
+		richacl_intern_put(cache->mc_entries[n].me_result);
+	}
+	pthread_mutex_destroy(&cache->mc_lock);
+	free(cache);
+}
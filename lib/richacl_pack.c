@@ -0,0 +1,91 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_pack  -  convert an acl into the packed representation
+ *
+ * The packed representation keeps the masks, identifiers, flags, types, and
+ * principal classes of the entries in separate arrays, and the unmapped
+ * identifiers in a separate string pool.  For large acls, this reduces the
+ * memory a permission check needs to look at considerably.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_packed *richacl_pack(const struct richacl *acl)
+{
+	const struct richace *ace;
+	struct richacl_packed *packed;
+	size_t who_size = 0, size;
+	unsigned int count = acl->a_count, n;
+	char *p;
+
+	richacl_for_each_entry(ace, acl) {
+		if (ace->e_flags & RICHACE_UNMAPPED_WHO)
+			who_size += strlen(ace->e_who) + 1;
+	}
+	size = sizeof(*packed) +
+	       count * (sizeof(unsigned int) + sizeof(id_t) +
+			2 * sizeof(unsigned short) + 1) + who_size;
+	packed = malloc(size);
+	if (!packed)
+		return NULL;
+
+	packed->p_flags = acl->a_flags;
+	packed->p_count = count;
+	packed->p_owner_mask = acl->a_owner_mask;
+	packed->p_group_mask = acl->a_group_mask;
+	packed->p_other_mask = acl->a_other_mask;
+	p = (char *)(packed + 1);
+	packed->p_masks = (unsigned int *)p;
+	p += count * sizeof(unsigned int);
+	packed->p_ids = (id_t *)p;
+	p += count * sizeof(id_t);
+	packed->p_ace_flags = (unsigned short *)p;
+	p += count * sizeof(unsigned short);
+	packed->p_types = (unsigned short *)p;
+	p += count * sizeof(unsigned short);
+	packed->p_classes = (unsigned char *)p;
+	p += count;
+	packed->p_who = p;
+	packed->p_who_size = who_size;
+
+	who_size = 0;
+	for (n = 0; n < count; n++) {
+		ace = &acl->a_entries[n];
+		packed->p_masks[n] = ace->e_mask;
+		packed->p_ace_flags[n] = ace->e_flags;
+		packed->p_types[n] = ace->e_type;
+		packed->p_classes[n] = richace_class(ace);
+		if (richace_is_inherit_only(ace))
+			packed->p_classes[n] |= RICHACL_PACKED_INHERIT_ONLY;
+		if (ace->e_flags & RICHACE_UNMAPPED_WHO) {
+			size_t len = strlen(ace->e_who) + 1;
+
+			memcpy(packed->p_who + who_size, ace->e_who, len);
+			packed->p_ids[n] = who_size;
+			who_size += len;
+		} else
+			packed->p_ids[n] = ace->e_id;
+	}
+	return packed;
+}
@@ -0,0 +1,59 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_packed_compare  -  compare two packed acls
+ *
+ * Entries with unmapped identifiers are compared by identifier.
+ *
+ * Returns 0 if the two acls are identical.
+ */
+int
+richacl_packed_compare(const struct richacl_packed *p1,
+		       const struct richacl_packed *p2)
+{
+	unsigned int count = p1->p_count;
+
+	if (p1->p_flags != p2->p_flags ||
+	    p1->p_count != p2->p_count ||
+	    p1->p_owner_mask != p2->p_owner_mask ||
+	    p1->p_group_mask != p2->p_group_mask ||
+	    p1->p_other_mask != p2->p_other_mask ||
+	    p1->p_who_size != p2->p_who_size)
+		return -1;
+	if (memcmp(p1->p_masks, p2->p_masks, count * sizeof(unsigned int)) ||
+	    memcmp(p1->p_ace_flags, p2->p_ace_flags,
+		   count * sizeof(unsigned short)) ||
+	    memcmp(p1->p_types, p2->p_types,
+		   count * sizeof(unsigned short)))
+		return -1;
+
+	/*
+	 * richacl_pack() adds the unmapped identifiers to the string pool in
+	 * entry order, so the offsets and pools are identical exactly when
+	 * the identifiers are.
+	 */
+	if (memcmp(p1->p_ids, p2->p_ids, count * sizeof(id_t)) ||
+	    memcmp(p1->p_who, p2->p_who, p1->p_who_size))
+		return -1;
+	return 0;
+}
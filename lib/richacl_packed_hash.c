@@ -0,0 +1,48 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_packed_hash  -  content hash of a packed acl
+ *
+ * Acls which richacl_packed_compare() considers identical have the same
+ * hash.  This is the same hash as richacl_hash() computes for the unpacked
+ * acl.
+ */
+uint64_t richacl_packed_hash(const struct richacl_packed *packed)
+{
+	uint64_t hash;
+	unsigned int n;
+
+	hash = richacl_hash_header(packed->p_flags, packed->p_count,
+				   packed->p_owner_mask, packed->p_group_mask,
+				   packed->p_other_mask);
+	for (n = 0; n < packed->p_count; n++) {
+		unsigned int flags = packed->p_ace_flags[n];
+		const char *who = NULL;
+
+		if (flags & RICHACE_UNMAPPED_WHO)
+			who = packed->p_who + packed->p_ids[n];
+		hash = richacl_hash_entry(hash, packed->p_types[n], flags,
+					  packed->p_masks[n], packed->p_ids[n],
+					  who);
+	}
+	return hash;
+}
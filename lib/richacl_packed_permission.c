@@ -0,0 +1,91 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_packed_permission  -  check if a process has the requested access
+ * @packed:	ACL of the file to check, from richacl_pack()
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @cred:	User and groups of the accessing process
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ *
+ * Returns what richacl_permission_cred() would return for the unpacked acl.
+ * Finding the matching entries only touches the class array, and the id
+ * array for user and group entries; the remaining arrays are only looked at
+ * for the entries which match.
+ */
+bool richacl_packed_permission(const struct richacl_packed *packed,
+			       uid_t owner, gid_t owning_group,
+			       const struct richacl_cred *cred,
+			       unsigned int mask)
+{
+	struct richacl_eval ev;
+	uid_t user = cred->cr_uid;
+	int in_owning_group = richacl_cred_in_group(cred, owning_group);
+	gid_t group_base = 0, group_max = (gid_t)-1;
+	const unsigned char *classes = packed->p_classes;
+	const id_t *ids = packed->p_ids;
+	unsigned int count = packed->p_count, n;
+
+	if (richacl_eval_init(&ev, packed->p_flags, packed->p_owner_mask,
+			      packed->p_group_mask, packed->p_other_mask,
+			      user == owner, in_owning_group, mask, mask))
+		goto out;
+
+	/* Groups outside the range of sorted credentials cannot match. */
+	if (cred->cr_sorted && cred->cr_n_groups) {
+		group_base = cred->cr_groups[0];
+		group_max = cred->cr_groups[cred->cr_n_groups - 1] - group_base;
+	}
+
+	for (n = 0; n < count; n++) {
+		/* Inherit-only entries end up in the default case. */
+		switch (classes[n]) {
+		case RICHACE_CLASS_OWNER:
+			if (user != owner)
+				continue;
+			break;
+		case RICHACE_CLASS_UID:
+			if (user != ids[n])
+				continue;
+			break;
+		case RICHACE_CLASS_GROUP:
+			if (!in_owning_group)
+				continue;
+			break;
+		case RICHACE_CLASS_GID:
+			if ((gid_t)(ids[n] - group_base) > group_max ||
+			    !richacl_cred_in_group(cred, ids[n]))
+				continue;
+			break;
+		case RICHACE_CLASS_EVERYONE:
+			break;
+		default:
+			continue;
+		}
+		if (richacl_eval_entry(&ev, classes[n], packed->p_types[n],
+				       packed->p_masks[n]))
+			break;
+	}
+
+out:
+	return richacl_eval_granted(&ev);
+}
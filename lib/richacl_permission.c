@@ -31,120 +31,19 @@
  * @n_groups:	Number of entries in @groups
  * @mask:	Requested permissions (RICHACE_* mask flags)
  *
- * Returns true if the requiested permissions are allowed.
+ * Returns true if the requiested permissions are allowed.  When checking the
+ * same user and groups repeatedly, use richacl_cred_alloc() and
+ * richacl_permission_cred() instead.
  */
 bool richacl_permission(struct richacl *acl, uid_t owner, gid_t owning_group,
 			uid_t user, const gid_t *groups, int n_groups,
 			unsigned int mask)
 {
-	const struct richace *ace;
-	unsigned int requested = mask;
-	int in_owning_group = in_groups(owning_group, groups, n_groups);
-	int in_owner_or_group_class = in_owning_group;
+	struct richacl_cred cred = {
+		.cr_uid = user,
+		.cr_groups = groups,
+		.cr_n_groups = n_groups,
+	};
 
-        /*
-	 * A process is
-	 *   - in the owner file class if it owns the file,
-	 *   - in the group file class if it is in the file's owning group or
-	 *     it matches any of the user or group entries, and
-	 *   - in the other file class otherwise.
-	 * The file class is only relevant for determining which file mask to
-	 * apply, which only happens for masked acls.
-	 */
-
-	if (acl->a_flags & RICHACL_MASKED) {
-		if ((acl->a_flags & RICHACL_WRITE_THROUGH) && user == owner)
-			return !(requested & ~acl->a_owner_mask);
-	} else {
-		/*
-		 * We don't care which class the process is in when the
-		 * acl is not masked.
-		 */
-		in_owner_or_group_class = 1;
-	}
-
-	/*
-	 * Check if the acl grants the requested access and determine which
-	 * file class the process is in.
-	 */
-	richacl_for_each_entry(ace, acl) {
-		unsigned int ace_mask = ace->e_mask;
-
-		if (richace_is_inherit_only(ace))
-			continue;
-		if (richace_is_owner(ace)) {
-			if (user != owner)
-				continue;
-			goto entry_matches_owner;
-		} else if (richace_is_group(ace)) {
-			if (!in_owning_group)
-				continue;
-		} else if (richace_is_unix_user(ace)) {
-			if (user != ace->e_id)
-				continue;
-			goto entry_matches_owner;
-		} else if (richace_is_unix_group(ace)) {
-			if (!in_groups(ace->e_id, groups, n_groups))
-				continue;
-		} else if (richace_is_everyone(ace))
-			goto entry_matches_everyone;
-		else
-			continue;
-
-		/*
-		 * Apply the group file mask to entries other than owner@ and
-		 * everyone@ or user entries matching the owner.  This ensures
-		 * that we grant the same permissions as the acl computed by
-		 * richacl_apply_masks().
-		 *
-		 * Without this restriction, the following richacl would grant
-		 * rw access to processes which are both the owner and in the
-		 * owning group, but not to other users in the owning group,
-		 * which could not be represented without masks:
-		 *
-		 *  owner:rw::mask
-		 *  group@:rw::allow
-		 */
-		if ((acl->a_flags & RICHACL_MASKED) && richace_is_allow(ace))
-			ace_mask &= acl->a_group_mask;
-
-entry_matches_owner:
-		/* The process is in the owner or group file class. */
-		in_owner_or_group_class = 1;
-
-entry_matches_everyone:
-		/* Check which mask flags the ACE allows or denies. */
-		if (richace_is_deny(ace) && (ace_mask & mask))
-			return false;
-		mask &= ~ace_mask;
-
-		/*
-		 * Keep going until we know which file class
-		 * the process is in.
-		 */
-		if (!mask && in_owner_or_group_class)
-			break;
-	}
-
-	if (acl->a_flags & RICHACL_MASKED) {
-		/*
-		 * The file class a process is in determines which file mask
-		 * applies.  Check if that file mask also grants the requested
-		 * access.
-		 */
-		if (user == owner) {
-			if (requested & ~acl->a_owner_mask)
-				return false;
-		} else if (in_owner_or_group_class) {
-			if (requested & ~acl->a_group_mask)
-				return false;
-		} else {
-			if (acl->a_flags & RICHACL_WRITE_THROUGH)
-				return !(requested & ~acl->a_other_mask);
-			else if (requested & ~acl->a_other_mask)
-				return false;
-		}
-	}
-
-	return !mask;
+	return richacl_permission_cred(acl, owner, owning_group, &cred, mask);
 }
@@ -0,0 +1,53 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_permission_cache  -  check if a process has the requested access
+ * @cache:	decision cache from richacl_cache_alloc()
+ * @acl:	ACL of the file to check
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @cred:	User and groups of the accessing process
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ *
+ * Like richacl_permission_cred(), but looks up the decision in @cache
+ * first, and remembers it there otherwise.
+ */
+bool richacl_permission_cache(struct richacl_cache *cache,
+			      const struct richacl *acl, uid_t owner,
+			      gid_t owning_group,
+			      const struct richacl_cred *cred,
+			      unsigned int mask)
+{
+	struct richacl_cache_key key;
+	unsigned int granted;
+	bool allowed;
+
+	if (!richacl_cache_key(&key, acl, owner, owning_group, cred,
+			       RICHACL_CACHE_PERMISSION, mask))
+		return richacl_permission_cred(acl, owner, owning_group,
+					       cred, mask);
+	if (richacl_cache_lookup(cache, &key, acl, &granted))
+		return granted == mask;
+	allowed = richacl_permission_cred(acl, owner, owning_group, cred, mask);
+	richacl_cache_insert(cache, &key, acl, allowed ? mask : 0);
+	return allowed;
+}
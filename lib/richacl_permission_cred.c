@@ -0,0 +1,65 @@
+/*
+  Copyright (C) 2006, 2009, 2010  Novell, Inc.
+  Copyright (C) 2015  Red Hat, Inc.
+  Written by Andreas Gruenbacher <agruenba@redhat.com>
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_permission_cred  -  check if a process has the requested access
+ * @acl:	ACL of the file to check
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @cred:	User and groups of the accessing process
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ *
+ * Returns true if the requiested permissions are allowed.
+ */
+bool richacl_permission_cred(const struct richacl *acl, uid_t owner,
+			     gid_t owning_group,
+			     const struct richacl_cred *cred,
+			     unsigned int mask)
+{
+	const struct richace *ace;
+	struct richacl_eval ev;
+	int in_owning_group = richacl_cred_in_group(cred, owning_group);
+
+	if (richacl_eval_init(&ev, acl->a_flags, acl->a_owner_mask,
+			      acl->a_group_mask, acl->a_other_mask,
+			      cred->cr_uid == owner, in_owning_group,
+			      mask, mask))
+		goto out;
+
+	/*
+	 * Check if the acl grants the requested access and determine which
+	 * file class the process is in.
+	 */
+	richacl_for_each_entry(ace, acl) {
+		unsigned int class;
+
+		class = richacl_eval_match(ace, owner, in_owning_group, cred);
+		if (class != RICHACE_CLASS_INVALID &&
+		    richacl_eval_entry(&ev, class, ace->e_type,
+				       ace->e_mask))
+			break;
+	}
+
+out:
+	return richacl_eval_granted(&ev);
+}
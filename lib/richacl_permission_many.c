@@ -0,0 +1,183 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+struct id_index {
+	id_t id;
+	unsigned int n;
+};
+
+static int id_index_cmp(const void *a, const void *b)
+{
+	const struct id_index *i1 = a, *i2 = b;
+
+	if (i1->id != i2->id)
+		return i1->id < i2->id ? -1 : 1;
+	return i1->n < i2->n ? -1 : i1->n > i2->n;
+}
+
+/* Find the first entry in @index for @id, or the end of @index. */
+static const struct id_index *
+id_index_find(const struct id_index *index, size_t count, id_t id)
+{
+	size_t lo = 0, hi = count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (index[mid].id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return index + lo;
+}
+
+/**
+ * richacl_permission_many  -  check if many processes have the requested access
+ * @acl:	ACL of the file to check
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @creds:	User and groups of each process
+ * @n:		Number of entries in @creds
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ * @results:	Result for each entry in @creds
+ *
+ * Sets @results[i] to what richacl_permission_cred(@acl, @owner,
+ * @owning_group, @creds[i], @mask) would return, but walks the entries of
+ * @acl only once.  The everyone@ entries are accumulated once for all
+ * processes, and user and group entries are matched against an index of
+ * the users and groups in @creds, so each entry only touches the processes
+ * it actually matches.
+ *
+ * Returns 0, or -1 with errno set on error.
+ */
+int richacl_permission_many(const struct richacl *acl, uid_t owner,
+			    gid_t owning_group,
+			    const struct richacl_cred *const *creds,
+			    unsigned int n, unsigned int mask, bool *results)
+{
+	const struct richace *ace;
+	struct richacl_eval *states;
+	struct id_index *users, *groups, *end;
+	const struct id_index *i, *users_end, *groups_end;
+	unsigned int everyone_decided = 0, everyone_allowed = 0;
+	size_t n_groups = 0;
+	unsigned int k;
+	int g;
+
+	for (k = 0; k < n; k++)
+		n_groups += creds[k]->cr_n_groups;
+	states = malloc(n * sizeof(*states) +
+			(n + n_groups) * sizeof(struct id_index));
+	if (!states && n)
+		return -1;
+	users = (struct id_index *)(states + n);
+	groups = users + n;
+	end = groups;
+	for (k = 0; k < n; k++) {
+		users[k].id = creds[k]->cr_uid;
+		users[k].n = k;
+		for (g = 0; g < creds[k]->cr_n_groups; g++) {
+			end->id = creds[k]->cr_groups[g];
+			end->n = k;
+			end++;
+		}
+		richacl_eval_init(&states[k], acl->a_flags, acl->a_owner_mask,
+				  acl->a_group_mask, acl->a_other_mask,
+				  creds[k]->cr_uid == owner, false, mask, mask);
+	}
+	qsort(users, n, sizeof(*users), id_index_cmp);
+	qsort(groups, n_groups, sizeof(*groups), id_index_cmp);
+	users_end = users + n;
+	groups_end = groups + n_groups;
+
+	/* A process in the owning group is in the group file class. */
+	for (i = id_index_find(groups, n_groups, owning_group);
+	     i != groups_end && i->id == owning_group; i++)
+		states[i->n].ev_in_owner_or_group_class = true;
+
+	richacl_for_each_entry(ace, acl) {
+		unsigned int class = richace_class(ace);
+		const struct id_index *index, *index_end;
+		id_t id;
+
+		if (richace_is_inherit_only(ace))
+			continue;
+		switch (class) {
+		case RICHACE_CLASS_EVERYONE:
+			if (!richace_is_deny(ace))
+				everyone_allowed |= ace->e_mask &
+						    ~everyone_decided;
+			everyone_decided |= ace->e_mask;
+			continue;
+		case RICHACE_CLASS_OWNER:
+			index = users;
+			index_end = users_end;
+			id = owner;
+			break;
+		case RICHACE_CLASS_GROUP:
+			index = groups;
+			index_end = groups_end;
+			id = owning_group;
+			break;
+		case RICHACE_CLASS_UID:
+			index = users;
+			index_end = users_end;
+			id = ace->e_id;
+			break;
+		case RICHACE_CLASS_GID:
+			index = groups;
+			index_end = groups_end;
+			id = ace->e_id;
+			break;
+		default:
+			continue;
+		}
+
+		/*
+		 * The everyone@ entries before this entry have already
+		 * decided the flags in @everyone_decided.
+		 */
+		for (i = id_index_find(index, index_end - index, id);
+		     i != index_end && i->id == id; i++)
+			richacl_eval_entry(&states[i->n], class, ace->e_type,
+					   ace->e_mask & ~everyone_decided);
+	}
+
+	for (k = 0; k < n; k++) {
+		/*
+		 * The flags no other entry decides are up to the everyone@
+		 * entries.  Those which they allow and those which they
+		 * deny are disjoint, so the order of applying them does not
+		 * matter.
+		 */
+		richacl_eval_entry(&states[k], RICHACE_CLASS_EVERYONE,
+				   RICHACE_ACCESS_DENIED_ACE_TYPE,
+				   everyone_decided & ~everyone_allowed);
+		richacl_eval_entry(&states[k], RICHACE_CLASS_EVERYONE,
+				   RICHACE_ACCESS_ALLOWED_ACE_TYPE,
+				   everyone_allowed);
+		results[k] = richacl_eval_granted(&states[k]);
+	}
+	free(states);
+	return 0;
+}
@@ -0,0 +1,143 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/*
+ * The evaluation loop of richacl_permission_cred() for acls of a given
+ * shape.  This function is instantiated for each combination of shape flags
+ * below; the tests against @shape are constant in each instance, so the
+ * branches which cannot be taken for acls of that shape are compiled out.
+ */
+static inline __attribute__((always_inline)) bool
+permission(const struct richacl *acl, uid_t owner, gid_t owning_group,
+	   const struct richacl_cred *cred, unsigned int mask,
+	   const unsigned int shape)
+{
+	const struct richace *ace;
+	struct richacl_eval ev;
+	uid_t user = cred->cr_uid;
+	int in_owning_group = richacl_cred_in_group(cred, owning_group);
+	unsigned int flags =
+		((shape & RICHACL_SHAPE_MASKED) ? RICHACL_MASKED : 0) |
+		((shape & RICHACL_SHAPE_WRITE_THROUGH) ?
+		 RICHACL_WRITE_THROUGH : 0);
+
+	if (richacl_eval_init(&ev, flags, acl->a_owner_mask,
+			      acl->a_group_mask, acl->a_other_mask,
+			      user == owner, in_owning_group, mask, mask))
+		goto out;
+
+	richacl_for_each_entry(ace, acl) {
+		unsigned int class = richace_class(ace);
+
+		if (!(shape & RICHACL_SHAPE_NO_INHERIT_ONLY) &&
+		    richace_is_inherit_only(ace))
+			continue;
+		switch (class) {
+		case RICHACE_CLASS_OWNER:
+			if (user != owner)
+				continue;
+			break;
+		case RICHACE_CLASS_GROUP:
+			if (!in_owning_group)
+				continue;
+			break;
+		case RICHACE_CLASS_EVERYONE:
+			break;
+		case RICHACE_CLASS_UID:
+			if ((shape & RICHACL_SHAPE_SPECIAL_ONLY) ||
+			    user != ace->e_id)
+				continue;
+			break;
+		case RICHACE_CLASS_GID:
+			if ((shape & RICHACL_SHAPE_SPECIAL_ONLY) ||
+			    !richacl_cred_in_group(cred, ace->e_id))
+				continue;
+			break;
+		default:
+			continue;
+		}
+		if (richacl_eval_entry(&ev, class,
+				       (shape & RICHACL_SHAPE_ALLOW_ONLY) ?
+				       RICHACE_ACCESS_ALLOWED_ACE_TYPE :
+				       ace->e_type, ace->e_mask))
+			break;
+	}
+
+out:
+	return richacl_eval_granted(&ev);
+}
+
+typedef bool (*permission_fn)(const struct richacl *, uid_t, gid_t,
+			      const struct richacl_cred *, unsigned int);
+
+#define PERMISSION(shape) \
+	static bool permission_ ## shape(const struct richacl *acl, \
+					 uid_t owner, gid_t owning_group, \
+					 const struct richacl_cred *cred, \
+					 unsigned int mask) \
+	{ \
+		return permission(acl, owner, owning_group, cred, mask, \
+				  shape); \
+	}
+
+PERMISSION(0)  PERMISSION(1)  PERMISSION(2)  PERMISSION(3)
+PERMISSION(4)  PERMISSION(5)  PERMISSION(6)  PERMISSION(7)
+PERMISSION(8)  PERMISSION(9)  PERMISSION(10) PERMISSION(11)
+PERMISSION(12) PERMISSION(13) PERMISSION(14) PERMISSION(15)
+PERMISSION(16) PERMISSION(17) PERMISSION(18) PERMISSION(19)
+PERMISSION(20) PERMISSION(21) PERMISSION(22) PERMISSION(23)
+PERMISSION(24) PERMISSION(25) PERMISSION(26) PERMISSION(27)
+PERMISSION(28) PERMISSION(29) PERMISSION(30) PERMISSION(31)
+
+static const permission_fn permission_fns[RICHACL_SHAPE_ALL + 1] = {
+	permission_0,  permission_1,  permission_2,  permission_3,
+	permission_4,  permission_5,  permission_6,  permission_7,
+	permission_8,  permission_9,  permission_10, permission_11,
+	permission_12, permission_13, permission_14, permission_15,
+	permission_16, permission_17, permission_18, permission_19,
+	permission_20, permission_21, permission_22, permission_23,
+	permission_24, permission_25, permission_26, permission_27,
+	permission_28, permission_29, permission_30, permission_31,
+};
+
+/**
+ * richacl_permission_shape  -  check if a process has the requested access
+ * @acl:	ACL of the file to check
+ * @shape:	shape of @acl as returned by richacl_shape()
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @cred:	User and groups of the accessing process
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ *
+ * Like richacl_permission_cred(), but uses an evaluation routine
+ * specialized for acls of shape @shape.  Classifying an acl once with
+ * richacl_shape() and checking it many times is faster than using
+ * richacl_permission_cred() for typical acls.
+ */
+bool richacl_permission_shape(const struct richacl *acl, unsigned int shape,
+			      uid_t owner, gid_t owning_group,
+			      const struct richacl_cred *cred,
+			      unsigned int mask)
+{
+	return permission_fns[shape & RICHACL_SHAPE_ALL](acl, owner,
+							 owning_group, cred,
+							 mask);
+}
@@ -0,0 +1,245 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <string.h>
+
+/* The AVX2 code relies on the layout of struct richace on x86_64. */
+#if HAVE_AVX2 && defined(__x86_64__)
+# define USE_AVX2 1
+# include <immintrin.h>
+#endif
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/*
+ * Compute which of the up to 64 entries starting at @ace match the process,
+ * except for unix group entries: those are returned in @group_entries and
+ * are resolved separately.
+ */
+static unsigned long long
+match_entries_scalar(const struct richace *ace, unsigned int count, uid_t user,
+		     int is_owner, int in_owning_group,
+		     unsigned long long *group_entries)
+{
+	unsigned long long matches = 0, groups = 0;
+	unsigned int n;
+
+	for (n = 0; n < count; n++) {
+		unsigned int flags = ace[n].e_flags;
+		id_t id = ace[n].e_id;
+		unsigned long long valid, special, group, match;
+
+		valid = !(flags & (RICHACE_INHERIT_ONLY_ACE |
+				   RICHACE_UNMAPPED_WHO));
+		special = !!(flags & RICHACE_SPECIAL_WHO);
+		group = !!(flags & RICHACE_IDENTIFIER_GROUP);
+
+		match = special & ((id == RICHACE_OWNER_SPECIAL_ID && is_owner) |
+				   (id == RICHACE_GROUP_SPECIAL_ID &&
+				    in_owning_group) |
+				   (id == RICHACE_EVERYONE_SPECIAL_ID));
+		match |= !special & !group & (id == user);
+		matches |= (valid & match) << n;
+		groups |= (valid & !special & group) << n;
+	}
+	*group_entries = groups;
+	return matches;
+}
+
+#if USE_AVX2
+/*
+ * Like match_entries_scalar(), eight entries at a time: the type and flags
+ * and the identifiers of the entries are transposed into one vector each,
+ * and all eight entries are compared at once.  The remaining entries are
+ * matched by match_entries_scalar().
+ */
+__attribute__((target("avx2")))
+static unsigned long long
+match_entries_avx2(const struct richace *ace, unsigned int count, uid_t user,
+		   int is_owner, int in_owning_group,
+		   unsigned long long *group_entries)
+{
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i invalid_flags = _mm256_set1_epi32(
+		RICHACE_INHERIT_ONLY_ACE | RICHACE_UNMAPPED_WHO);
+	const __m256i special_flag = _mm256_set1_epi32(RICHACE_SPECIAL_WHO);
+	const __m256i group_flag = _mm256_set1_epi32(RICHACE_IDENTIFIER_GROUP);
+	const __m256i owner_id = _mm256_set1_epi32(RICHACE_OWNER_SPECIAL_ID);
+	const __m256i group_id = _mm256_set1_epi32(RICHACE_GROUP_SPECIAL_ID);
+	const __m256i everyone_id = _mm256_set1_epi32(RICHACE_EVERYONE_SPECIAL_ID);
+	const __m256i user_id = _mm256_set1_epi32(user);
+	const __m256i owner = _mm256_set1_epi32(is_owner ? -1 : 0);
+	const __m256i owning_group = _mm256_set1_epi32(in_owning_group ? -1 : 0);
+	unsigned long long matches = 0, groups = 0, rest_groups;
+	unsigned int n;
+
+	for (n = 0; n + 8 <= count; n += 8) {
+		const __m256i *p = (const __m256i *)(ace + n);
+		__m256i e01, e23, e45, e67, lo0123, hi0123, lo4567, hi4567;
+		__m256i flags, id, valid, special, group, match;
+
+		/*
+		 * Each entry is four 32-bit words: type and flags, mask, and
+		 * the identifier (two words for the e_who pointer).
+		 */
+		e01 = _mm256_loadu_si256(p);
+		e23 = _mm256_loadu_si256(p + 1);
+		e45 = _mm256_loadu_si256(p + 2);
+		e67 = _mm256_loadu_si256(p + 3);
+		lo0123 = _mm256_unpacklo_epi32(e01, e23);
+		hi0123 = _mm256_unpackhi_epi32(e01, e23);
+		lo4567 = _mm256_unpacklo_epi32(e45, e67);
+		hi4567 = _mm256_unpackhi_epi32(e45, e67);
+		/* Entries 0, 2, 4, 6, 1, 3, 5, 7, then back in order. */
+		flags = _mm256_unpacklo_epi64(lo0123, lo4567);
+		flags = _mm256_permutevar8x32_epi32(flags, order);
+		flags = _mm256_srli_epi32(flags, 16);
+		id = _mm256_unpacklo_epi64(hi0123, hi4567);
+		id = _mm256_permutevar8x32_epi32(id, order);
+
+		valid = _mm256_cmpeq_epi32(
+			_mm256_and_si256(flags, invalid_flags), zero);
+		special = _mm256_cmpeq_epi32(
+			_mm256_and_si256(flags, special_flag), special_flag);
+		group = _mm256_cmpeq_epi32(
+			_mm256_and_si256(flags, group_flag), group_flag);
+
+		match = _mm256_or_si256(
+			_mm256_cmpeq_epi32(id, everyone_id),
+			_mm256_or_si256(
+				_mm256_and_si256(
+					_mm256_cmpeq_epi32(id, owner_id), owner),
+				_mm256_and_si256(
+					_mm256_cmpeq_epi32(id, group_id),
+					owning_group)));
+		match = _mm256_or_si256(
+			_mm256_and_si256(special, match),
+			_mm256_andnot_si256(_mm256_or_si256(special, group),
+					    _mm256_cmpeq_epi32(id, user_id)));
+		match = _mm256_and_si256(valid, match);
+		group = _mm256_and_si256(valid,
+					 _mm256_andnot_si256(special, group));
+
+		matches |= (unsigned long long)_mm256_movemask_ps(
+			_mm256_castsi256_ps(match)) << n;
+		groups |= (unsigned long long)_mm256_movemask_ps(
+			_mm256_castsi256_ps(group)) << n;
+	}
+	if (n < count) {
+		matches |= match_entries_scalar(ace + n, count - n, user,
+						is_owner, in_owning_group,
+						&rest_groups) << n;
+		groups |= rest_groups << n;
+	}
+	*group_entries = groups;
+	return matches;
+}
+#endif
+
+static unsigned long long
+match_entries(const struct richace *ace, unsigned int count, uid_t user,
+	      int is_owner, int in_owning_group,
+	      unsigned long long *group_entries)
+{
+#if USE_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return match_entries_avx2(ace, count, user, is_owner,
+					  in_owning_group, group_entries);
+#endif
+	return match_entries_scalar(ace, count, user, is_owner,
+				    in_owning_group, group_entries);
+}
+
+static bool permission(const struct richacl *acl, uid_t owner,
+		       int in_owning_group, const struct richacl_cred *cred,
+		       unsigned int mask)
+{
+	struct richacl_eval ev;
+	uid_t user = cred->cr_uid;
+	unsigned int start;
+
+	if (richacl_eval_init(&ev, acl->a_flags, acl->a_owner_mask,
+			      acl->a_group_mask, acl->a_other_mask,
+			      user == owner, in_owning_group, mask, mask))
+		goto out;
+
+	for (start = 0; start < acl->a_count; start += 64) {
+		const struct richace *ace = acl->a_entries + start;
+		unsigned int count = acl->a_count - start;
+		unsigned long long matches, groups;
+
+		if (count > 64)
+			count = 64;
+		matches = match_entries(ace, count, user, user == owner,
+					in_owning_group, &groups);
+		while (groups) {
+			int n = ffsll(groups) - 1;
+
+			groups &= groups - 1;
+			if (richacl_cred_in_group(cred, ace[n].e_id))
+				matches |= 1ULL << n;
+		}
+
+		while (matches) {
+			int n = ffsll(matches) - 1;
+
+			matches &= matches - 1;
+			if (richacl_eval_entry(&ev, richace_class(&ace[n]),
+					       ace[n].e_type, ace[n].e_mask))
+				goto out;
+		}
+	}
+
+out:
+	return richacl_eval_granted(&ev);
+}
+
+/**
+ * richacl_permission_vec  -  check if a process has the requested access to many files
+ * @cred:	User and groups of the accessing process
+ * @acls:	ACLs of the files to check
+ * @owners:	Owner of each file
+ * @owning_groups: Owning group of each file
+ * @n:		Number of files
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ * @results:	Result for each file
+ *
+ * Sets @results[i] to what richacl_permission_cred(@acls[i], @owners[i],
+ * @owning_groups[i], @cred, @mask) would return.  The entries of each acl
+ * are matched against @cred in blocks of 64 without branching on the
+ * individual entries, with AVX2 when the processor supports it; only the
+ * matching entries are then visited in order.
+ */
+void richacl_permission_vec(const struct richacl_cred *cred,
+			    const struct richacl *const *acls,
+			    const uid_t *owners, const gid_t *owning_groups,
+			    unsigned int n, unsigned int mask, bool *results)
+{
+	int in_owning_group = 0;
+	unsigned int k;
+
+	for (k = 0; k < n; k++) {
+		if (k == 0 || owning_groups[k] != owning_groups[k - 1])
+			in_owning_group =
+				richacl_cred_in_group(cred, owning_groups[k]);
+		results[k] = permission(acls[k], owners[k], in_owning_group,
+					cred, mask);
+	}
+}
@@ -0,0 +1,160 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/* Process the items of the current job, starting with range @index. */
+static void pool_work(struct richacl_pool *pool, unsigned int index)
+{
+	unsigned int k;
+
+	for (k = 0; k < pool->p_workers; k++) {
+		struct richacl_pool_range *range =
+			&pool->p_ranges[(index + k) % pool->p_workers];
+
+		for (;;) {
+			unsigned int n = __atomic_fetch_add(&range->pr_next, 1,
+							    __ATOMIC_RELAXED);
+
+			if (n >= range->pr_end)
+				break;
+			pool->p_fn(pool->p_arg, n);
+		}
+	}
+}
+
+static void *pool_thread(void *arg)
+{
+	struct richacl_pool_thread *thread = arg;
+	struct richacl_pool *pool = thread->pt_pool;
+	unsigned long generation = 0;
+
+	pthread_mutex_lock(&pool->p_lock);
+	for (;;) {
+		while (!pool->p_stop && pool->p_generation == generation)
+			pthread_cond_wait(&pool->p_work, &pool->p_lock);
+		if (pool->p_stop)
+			break;
+		generation = pool->p_generation;
+		pthread_mutex_unlock(&pool->p_lock);
+
+		pool_work(pool, thread->pt_index);
+
+		pthread_mutex_lock(&pool->p_lock);
+		if (!--pool->p_busy)
+			pthread_cond_signal(&pool->p_idle);
+	}
+	pthread_mutex_unlock(&pool->p_lock);
+	return NULL;
+}
+
+/**
+ * richacl_pool_start  -  start the worker threads of @pool
+ *
+ * @pool->p_workers must be set, and @pool->p_threads must have room for
+ * @pool->p_workers - 1 threads.
+ */
+int richacl_pool_start(struct richacl_pool *pool)
+{
+	unsigned int n;
+
+	for (n = 1; n < pool->p_workers; n++) {
+		struct richacl_pool_thread *thread = &pool->p_threads[n - 1];
+
+		thread->pt_pool = pool;
+		thread->pt_index = n;
+		errno = pthread_create(&thread->pt_thread, NULL, pool_thread,
+				       thread);
+		if (errno) {
+			int saved_errno = errno;
+
+			/* Only stop the threads which were started. */
+			pool->p_workers = n;
+			richacl_pool_stop(pool);
+			errno = saved_errno;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * richacl_pool_stop  -  stop the worker threads of @pool
+ */
+void richacl_pool_stop(struct richacl_pool *pool)
+{
+	unsigned int n;
+
+	pthread_mutex_lock(&pool->p_lock);
+	pool->p_stop = true;
+	pthread_cond_broadcast(&pool->p_work);
+	pthread_mutex_unlock(&pool->p_lock);
+	for (n = 1; n < pool->p_workers; n++)
+		pthread_join(pool->p_threads[n - 1].pt_thread, NULL);
+}
+
+/**
+ * richacl_pool_run  -  call a function for each of a number of items
+ * @pool:	pool to use, or NULL to process all items in the calling thread
+ * @count:	number of items
+ * @fn:		function to call with @arg and each item number
+ * @arg:	first argument of @fn
+ *
+ * The items are split evenly between the workers, which steal items from
+ * each other when they run out of work.  The calling thread is one of the
+ * workers.  Returns when all items have been processed.
+ */
+void richacl_pool_run(struct richacl_pool *pool, unsigned int count,
+		      void (*fn)(void *, unsigned int), void *arg)
+{
+	unsigned int n;
+
+	if (!pool || pool->p_workers == 1 || count <= 1) {
+		for (n = 0; n < count; n++)
+			fn(arg, n);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->p_run_lock);
+	for (n = 0; n < pool->p_workers; n++) {
+		struct richacl_pool_range *range = &pool->p_ranges[n];
+
+		range->pr_next = (unsigned long long)count * n / pool->p_workers;
+		range->pr_end = (unsigned long long)count * (n + 1) /
+				pool->p_workers;
+	}
+
+	pthread_mutex_lock(&pool->p_lock);
+	pool->p_fn = fn;
+	pool->p_arg = arg;
+	pool->p_busy = pool->p_workers - 1;
+	pool->p_generation++;
+	pthread_cond_broadcast(&pool->p_work);
+	pthread_mutex_unlock(&pool->p_lock);
+
+	pool_work(pool, 0);
+
+	pthread_mutex_lock(&pool->p_lock);
+	while (pool->p_busy)
+		pthread_cond_wait(&pool->p_idle, &pool->p_lock);
+	pthread_mutex_unlock(&pool->p_lock);
+	pthread_mutex_unlock(&pool->p_run_lock);
+}
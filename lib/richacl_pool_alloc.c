@@ -0,0 +1,76 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_pool_alloc  -  allocate a pool of workers for the bulk functions
+ * @workers:	number of workers, including the thread calling the bulk
+ *		functions, or 0 for one per online processor
+ *
+ * richacl_bulk_get(), richacl_bulk_set(), and richacl_bulk_access() spread
+ * the files to process over the workers of the pool.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_pool *richacl_pool_alloc(unsigned int workers)
+{
+	struct richacl_pool *pool;
+
+	if (!workers) {
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+		workers = online > 0 ? online : 1;
+	}
+	pool = calloc(1, sizeof(*pool));
+	if (!pool)
+		return NULL;
+	pool->p_workers = workers;
+	pool->p_threads = calloc(workers - 1 ? workers - 1 : 1,
+				 sizeof(*pool->p_threads));
+	if (posix_memalign((void **)&pool->p_ranges,
+			   __alignof__(*pool->p_ranges),
+			   workers * sizeof(*pool->p_ranges)))
+		pool->p_ranges = NULL;
+	if (!pool->p_threads || !pool->p_ranges) {
+		errno = ENOMEM;
+		goto fail;
+	}
+	pthread_mutex_init(&pool->p_run_lock, NULL);
+	pthread_mutex_init(&pool->p_lock, NULL);
+	pthread_cond_init(&pool->p_work, NULL);
+	pthread_cond_init(&pool->p_idle, NULL);
+	if (richacl_pool_start(pool)) {
+		pthread_cond_destroy(&pool->p_idle);
+		pthread_cond_destroy(&pool->p_work);
+		pthread_mutex_destroy(&pool->p_lock);
+		pthread_mutex_destroy(&pool->p_run_lock);
+		goto fail;
+	}
+	return pool;
+
+fail:
+	free(pool->p_ranges);
+	free(pool->p_threads);
+	free(pool);
+	return NULL;
+}
@@ -0,0 +1,38 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_pool_free  -  stop the workers and free a pool
+ */
+void richacl_pool_free(struct richacl_pool *pool)
+{
+	if (!pool)
+		return;
+	richacl_pool_stop(pool);
+	pthread_cond_destroy(&pool->p_idle);
+	pthread_cond_destroy(&pool->p_work);
+	pthread_mutex_destroy(&pool->p_lock);
+	pthread_mutex_destroy(&pool->p_run_lock);
+	free(pool->p_ranges);
+	free(pool->p_threads);
+	free(pool);
+}
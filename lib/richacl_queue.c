@@ -0,0 +1,576 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/xattr.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if HAVE_DECL_IORING_OP_GETXATTR
+#include <linux/io_uring.h>
+#endif
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+#if HAVE_DECL_IORING_OP_GETXATTR && defined(__NR_io_uring_setup)
+#define USE_IO_URING 1
+#endif
+
+/**
+ * struct richacl_queue_slot  -  state of a queued request
+ * @qs_data:	argument for the completion callback
+ * @qs_path:	file name, or NULL
+ * @qs_fd:	file descriptor if @qs_path is NULL
+ * @qs_op:	RICHACL_QUEUE_GET or RICHACL_QUEUE_SET
+ * @qs_flags:	RICHACL_QUEUE_STAT
+ * @qs_pending:	number of operations which have not completed yet
+ * @qs_result:	size of the xattr value read, 0 for writes, or -errno
+ * @qs_stat_error: 0, or the errno from determining the file status
+ * @qs_value:	xattr value; points to @qs_buffer unless it does not fit
+ * @qs_value_size: size of @qs_value
+ * @qs_buffer:	RICHACL_ACCESS_BUFFER_SIZE bytes in struct richacl_queue
+ * @qs_stat:	file status
+ */
+struct richacl_queue_slot {
+	void *qs_data;
+	const char *qs_path;
+	int qs_fd;
+	unsigned char qs_op;
+	unsigned char qs_flags;
+	unsigned char qs_pending;
+	ssize_t qs_result;
+	int qs_stat_error;
+	void *qs_value;
+	size_t qs_value_size;
+	void *qs_buffer;
+	struct stat qs_stat;
+#ifdef USE_IO_URING
+	struct statx qs_statx;
+#endif
+};
+
+static ssize_t getxattr_slot(struct richacl_queue *q,
+			     struct richacl_queue_slot *slot,
+			     void *value, size_t size)
+{
+	if (slot->qs_path)
+		return getxattr(slot->qs_path, q->q_name, value, size);
+	return fgetxattr(slot->qs_fd, q->q_name, value, size);
+}
+
+/*
+ * Read the xattr value into @slot, into an allocated buffer if it does not
+ * fit into the slot's buffer.  Like richacl_get_file().
+ */
+static ssize_t get_value(struct richacl_queue *q,
+			 struct richacl_queue_slot *slot)
+{
+	ssize_t retval;
+
+	retval = getxattr_slot(q, slot, slot->qs_value, slot->qs_value_size);
+	while (retval < 0 && errno == ERANGE) {
+		retval = getxattr_slot(q, slot, NULL, 0);
+		if (retval <= 0)
+			break;
+		if (slot->qs_value != slot->qs_buffer)
+			free(slot->qs_value);
+		slot->qs_value = malloc(retval);
+		if (!slot->qs_value) {
+			slot->qs_value = slot->qs_buffer;
+			return -errno;
+		}
+		slot->qs_value_size = retval;
+		retval = getxattr_slot(q, slot, slot->qs_value, retval);
+	}
+	return retval < 0 ? -errno : retval;
+}
+
+/*
+ * Free @slot and hand its result to the completion callback.  The slot is
+ * freed first so that the callback can queue further requests.
+ */
+static void complete(struct richacl_queue *q, struct richacl_queue_slot *slot)
+{
+	struct richacl *acl = NULL;
+	const struct stat *st = NULL;
+	struct stat st_buf;
+	void *data = slot->qs_data;
+	int error = 0;
+
+	if (slot->qs_result < 0)
+		error = -slot->qs_result;
+	else if (slot->qs_op == RICHACL_QUEUE_GET) {
+		acl = richacl_from_xattr(slot->qs_value, slot->qs_result);
+		if (!acl)
+			error = errno;
+	}
+	if (slot->qs_flags & RICHACL_QUEUE_STAT) {
+		if (!slot->qs_stat_error) {
+			st_buf = slot->qs_stat;
+			st = &st_buf;
+		} else if (!error)
+			error = slot->qs_stat_error;
+	}
+	if (slot->qs_value != slot->qs_buffer)
+		free(slot->qs_value);
+	q->q_free[q->q_n_free++] = slot - q->q_slots;
+	q->q_done(data, acl, st, error);
+}
+
+static void run_sync(struct richacl_queue *q, struct richacl_queue_slot *slot)
+{
+	int ret;
+
+	if (slot->qs_op == RICHACL_QUEUE_GET) {
+		slot->qs_result = get_value(q, slot);
+		if (slot->qs_flags & RICHACL_QUEUE_STAT) {
+			if (slot->qs_path)
+				ret = stat(slot->qs_path, &slot->qs_stat);
+			else
+				ret = fstat(slot->qs_fd, &slot->qs_stat);
+			slot->qs_stat_error = ret ? errno : 0;
+		}
+	} else {
+		if (slot->qs_path)
+			ret = setxattr(slot->qs_path, q->q_name, slot->qs_value,
+				       slot->qs_value_size, 0);
+		else
+			ret = fsetxattr(slot->qs_fd, q->q_name, slot->qs_value,
+					slot->qs_value_size, 0);
+		slot->qs_result = ret ? -errno : 0;
+	}
+	complete(q, slot);
+}
+
+#ifdef USE_IO_URING
+
+/**
+ * struct richacl_queue_ring  -  io_uring instance
+ * @r_fd:	io_uring file descriptor
+ * @r_ring:	submission and completion queue rings
+ * @r_ring_size: size of @r_ring
+ * @r_sqes:	submission queue entries
+ * @r_sqes_size: size of @r_sqes
+ * @r_sq_tail:	tail of the submission queue visible to the kernel
+ * @r_sq_local:	tail of the submission queue including unpublished entries
+ * @r_sq_mask:	number of submission queue entries - 1
+ * @r_to_submit: number of entries not submitted yet
+ * @r_cq_head:	head of the completion queue
+ * @r_cq_tail:	tail of the completion queue
+ * @r_cq_mask:	number of completion queue entries - 1
+ * @r_cqes:	completion queue entries
+ */
+struct richacl_queue_ring {
+	int r_fd;
+	void *r_ring;
+	size_t r_ring_size;
+	struct io_uring_sqe *r_sqes;
+	size_t r_sqes_size;
+	unsigned int *r_sq_tail;
+	unsigned int r_sq_local;
+	unsigned int r_sq_mask;
+	unsigned int r_to_submit;
+	unsigned int *r_cq_head;
+	unsigned int *r_cq_tail;
+	unsigned int r_cq_mask;
+	struct io_uring_cqe *r_cqes;
+};
+
+static const unsigned char ring_ops[] = {
+	IORING_OP_GETXATTR, IORING_OP_FGETXATTR,
+	IORING_OP_SETXATTR, IORING_OP_FSETXATTR,
+	IORING_OP_STATX,
+};
+
+/* Check if the kernel supports all the operations in ring_ops[]. */
+static bool ring_supported(int fd)
+{
+	struct io_uring_probe *probe;
+	unsigned int n;
+	bool supported = false;
+
+	probe = calloc(1, sizeof(*probe) + 256 * sizeof(probe->ops[0]));
+	if (!probe)
+		return false;
+	if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE,
+		    probe, 256) == 0) {
+		supported = true;
+		for (n = 0; n < sizeof(ring_ops); n++) {
+			if (ring_ops[n] > probe->last_op ||
+			    !(probe->ops[ring_ops[n]].flags &
+			      IO_URING_OP_SUPPORTED))
+				supported = false;
+		}
+	}
+	free(probe);
+	return supported;
+}
+
+static void ring_free(struct richacl_queue_ring *r)
+{
+	if (r->r_sqes)
+		munmap(r->r_sqes, r->r_sqes_size);
+	if (r->r_ring)
+		munmap(r->r_ring, r->r_ring_size);
+	close(r->r_fd);
+	free(r);
+}
+
+/*
+ * Set up an io_uring instance with @entries submission queue entries.
+ * Returns NULL when io_uring or any of the operations we need are not
+ * available.
+ */
+static struct richacl_queue_ring *ring_alloc(unsigned int entries)
+{
+	struct richacl_queue_ring *r;
+	struct io_uring_params p;
+	size_t cq_size;
+	unsigned int *array, n;
+
+	r = calloc(1, sizeof(*r));
+	if (!r)
+		return NULL;
+	memset(&p, 0, sizeof(p));
+	r->r_fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (r->r_fd < 0) {
+		free(r);
+		return NULL;
+	}
+	if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !ring_supported(r->r_fd))
+		goto fail;
+
+	r->r_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (r->r_ring_size < cq_size)
+		r->r_ring_size = cq_size;
+	r->r_ring = mmap(NULL, r->r_ring_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, r->r_fd, IORING_OFF_SQ_RING);
+	if (r->r_ring == MAP_FAILED) {
+		r->r_ring = NULL;
+		goto fail;
+	}
+	r->r_sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->r_sqes = mmap(NULL, r->r_sqes_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, r->r_fd, IORING_OFF_SQES);
+	if (r->r_sqes == MAP_FAILED) {
+		r->r_sqes = NULL;
+		goto fail;
+	}
+
+	r->r_sq_tail = r->r_ring + p.sq_off.tail;
+	r->r_sq_local = *r->r_sq_tail;
+	r->r_sq_mask = *(unsigned int *)(r->r_ring + p.sq_off.ring_mask);
+	r->r_cq_head = r->r_ring + p.cq_off.head;
+	r->r_cq_tail = r->r_ring + p.cq_off.tail;
+	r->r_cq_mask = *(unsigned int *)(r->r_ring + p.cq_off.ring_mask);
+	r->r_cqes = r->r_ring + p.cq_off.cqes;
+
+	/* Submission queue entry n always goes into slot n of the ring. */
+	array = r->r_ring + p.sq_off.array;
+	for (n = 0; n < p.sq_entries; n++)
+		array[n] = n;
+	return r;
+
+fail:
+	ring_free(r);
+	return NULL;
+}
+
+static struct io_uring_sqe *ring_sqe(struct richacl_queue_ring *r)
+{
+	struct io_uring_sqe *sqe = &r->r_sqes[r->r_sq_local & r->r_sq_mask];
+
+	memset(sqe, 0, sizeof(*sqe));
+	r->r_sq_local++;
+	r->r_to_submit++;
+	return sqe;
+}
+
+/*
+ * Submit the queued entries, and wait until at least @wait operations have
+ * completed.
+ */
+static int ring_enter(struct richacl_queue_ring *r, unsigned int wait)
+{
+	int ret;
+
+	__atomic_store_n(r->r_sq_tail, r->r_sq_local, __ATOMIC_RELEASE);
+	do {
+		ret = syscall(__NR_io_uring_enter, r->r_fd, r->r_to_submit,
+			      wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0)
+		return -1;
+	r->r_to_submit -= ret;
+	return 0;
+}
+
+static void ring_complete(struct richacl_queue *q, uint64_t user_data,
+			  int res)
+{
+	struct richacl_queue_slot *slot = &q->q_slots[user_data >> 1];
+
+	if (user_data & 1) {
+		const struct statx *stx = &slot->qs_statx;
+		struct stat *st = &slot->qs_stat;
+
+		if (res < 0) {
+			slot->qs_stat_error = -res;
+			goto out;
+		}
+		memset(st, 0, sizeof(*st));
+		st->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+		st->st_ino = stx->stx_ino;
+		st->st_mode = stx->stx_mode;
+		st->st_nlink = stx->stx_nlink;
+		st->st_uid = stx->stx_uid;
+		st->st_gid = stx->stx_gid;
+		st->st_rdev = makedev(stx->stx_rdev_major, stx->stx_rdev_minor);
+		st->st_size = stx->stx_size;
+		st->st_blksize = stx->stx_blksize;
+		st->st_blocks = stx->stx_blocks;
+		st->st_atim.tv_sec = stx->stx_atime.tv_sec;
+		st->st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+		st->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+		st->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+		st->st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+		st->st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+	} else if (res == -ERANGE && slot->qs_op == RICHACL_QUEUE_GET) {
+		/* The acl does not fit into the slot's buffer. */
+		slot->qs_result = get_value(q, slot);
+	} else
+		slot->qs_result = res;
+out:
+	if (!--slot->qs_pending)
+		complete(q, slot);
+}
+
+/*
+ * Submit the queued entries, wait until at least @wait operations have
+ * completed, and complete all finished requests.  Completion callbacks
+ * which queue requests can end up in here recursively, so the completion
+ * queue head is reloaded for each entry.
+ */
+static int ring_reap(struct richacl_queue *q, unsigned int wait)
+{
+	struct richacl_queue_ring *r = q->q_ring;
+	unsigned int head = *r->r_cq_head, tail;
+
+	tail = __atomic_load_n(r->r_cq_tail, __ATOMIC_ACQUIRE);
+	if (tail - head < wait || r->r_to_submit) {
+		/* The completions not reaped yet count towards @wait. */
+		if (ring_enter(r, tail - head < wait ? wait : 0))
+			return -1;
+	}
+	while ((head = *r->r_cq_head) !=
+	       __atomic_load_n(r->r_cq_tail, __ATOMIC_ACQUIRE)) {
+		struct io_uring_cqe *cqe = &r->r_cqes[head & r->r_cq_mask];
+		uint64_t user_data = cqe->user_data;
+		int res = cqe->res;
+
+		__atomic_store_n(r->r_cq_head, head + 1, __ATOMIC_RELEASE);
+		ring_complete(q, user_data, res);
+	}
+	return 0;
+}
+
+static void ring_queue(struct richacl_queue *q, struct richacl_queue_slot *slot)
+{
+	struct richacl_queue_ring *r = q->q_ring;
+	uint64_t user_data = (uint64_t)(slot - q->q_slots) << 1;
+	struct io_uring_sqe *sqe;
+
+	sqe = ring_sqe(r);
+	if (slot->qs_path) {
+		sqe->opcode = slot->qs_op == RICHACL_QUEUE_GET ?
+			IORING_OP_GETXATTR : IORING_OP_SETXATTR;
+		sqe->addr3 = (uintptr_t)slot->qs_path;
+	} else {
+		sqe->opcode = slot->qs_op == RICHACL_QUEUE_GET ?
+			IORING_OP_FGETXATTR : IORING_OP_FSETXATTR;
+		sqe->fd = slot->qs_fd;
+	}
+	sqe->addr = (uintptr_t)q->q_name;
+	sqe->addr2 = (uintptr_t)slot->qs_value;
+	sqe->len = slot->qs_value_size;
+	sqe->user_data = user_data;
+	slot->qs_pending = 1;
+
+	if (slot->qs_flags & RICHACL_QUEUE_STAT) {
+		sqe = ring_sqe(r);
+		sqe->opcode = IORING_OP_STATX;
+		if (slot->qs_path) {
+			sqe->fd = AT_FDCWD;
+			sqe->addr = (uintptr_t)slot->qs_path;
+		} else {
+			sqe->fd = slot->qs_fd;
+			sqe->addr = (uintptr_t)"";
+			sqe->statx_flags = AT_EMPTY_PATH;
+		}
+		sqe->len = STATX_BASIC_STATS;
+		sqe->addr2 = (uintptr_t)&slot->qs_statx;
+		sqe->user_data = user_data | 1;
+		slot->qs_pending++;
+	}
+}
+
+#else  /* USE_IO_URING */
+
+static struct richacl_queue_ring *ring_alloc(unsigned int entries)
+{
+	return NULL;
+}
+
+static void ring_free(struct richacl_queue_ring *r)
+{
+}
+
+static int ring_reap(struct richacl_queue *q, unsigned int wait)
+{
+	return 0;
+}
+
+static void ring_queue(struct richacl_queue *q, struct richacl_queue_slot *slot)
+{
+}
+
+#endif  /* USE_IO_URING */
+
+/**
+ * richacl_queue_setup  -  allocate the request slots and the io_uring instance
+ * @q:		queue to set up
+ * @depth:	maximum number of requests in flight
+ * @use_ring:	use io_uring if available
+ *
+ * Without io_uring, requests are carried out synchronously.
+ */
+int richacl_queue_setup(struct richacl_queue *q, unsigned int depth,
+			bool use_ring)
+{
+	unsigned int n;
+
+	q->q_slots = calloc(depth, sizeof(*q->q_slots));
+	q->q_buffers = malloc(depth * RICHACL_ACCESS_BUFFER_SIZE);
+	q->q_free = malloc(depth * sizeof(*q->q_free));
+	if (!q->q_slots || !q->q_buffers || !q->q_free) {
+		richacl_queue_teardown(q);
+		return -1;
+	}
+	q->q_depth = depth;
+	for (n = 0; n < depth; n++) {
+		q->q_slots[n].qs_buffer =
+			q->q_buffers + n * RICHACL_ACCESS_BUFFER_SIZE;
+		q->q_free[n] = depth - 1 - n;
+	}
+	q->q_n_free = depth;
+	/* A read with RICHACL_QUEUE_STAT takes two submission queue entries. */
+	if (use_ring)
+		q->q_ring = ring_alloc(2 * depth);
+	return 0;
+}
+
+/**
+ * richacl_queue_push  -  queue a request
+ * @q:		queue
+ * @op:		RICHACL_QUEUE_GET or RICHACL_QUEUE_SET
+ * @path:	file name, or NULL
+ * @fd:		file descriptor if @path is NULL
+ * @acl:	acl to write (RICHACL_QUEUE_SET)
+ * @flags:	RICHACL_QUEUE_STAT (RICHACL_QUEUE_GET)
+ * @data:	argument for the completion callback
+ *
+ * When all slots are in use, waits for some of the requests in flight to
+ * complete first.  Requests are submitted in batches.  Completion callbacks
+ * may queue further requests.
+ */
+int richacl_queue_push(struct richacl_queue *q, int op, const char *path,
+		       int fd, const struct richacl *acl, int flags,
+		       void *data)
+{
+	struct richacl_queue_slot *slot;
+
+	if (flags & ~RICHACL_QUEUE_STAT) {
+		errno = EINVAL;
+		return -1;
+	}
+	while (!q->q_n_free) {
+		if (ring_reap(q, (q->q_depth + 3) / 4))
+			return -1;
+	}
+	slot = &q->q_slots[q->q_free[q->q_n_free - 1]];
+	slot->qs_value = slot->qs_buffer;
+	slot->qs_value_size = RICHACL_ACCESS_BUFFER_SIZE;
+	if (op == RICHACL_QUEUE_SET) {
+		size_t size = richacl_xattr_size(acl);
+
+		if (size > RICHACL_ACCESS_BUFFER_SIZE) {
+			slot->qs_value = malloc(size);
+			if (!slot->qs_value)
+				return -1;
+		}
+		richacl_to_xattr(acl, slot->qs_value);
+		slot->qs_value_size = size;
+	}
+	q->q_n_free--;
+	slot->qs_data = data;
+	slot->qs_path = path;
+	slot->qs_fd = fd;
+	slot->qs_op = op;
+	slot->qs_flags = flags;
+	slot->qs_result = 0;
+	slot->qs_stat_error = 0;
+
+	if (q->q_ring)
+		ring_queue(q, slot);
+	else
+		run_sync(q, slot);
+	return 0;
+}
+
+/**
+ * richacl_queue_drain  -  wait for all requests in flight to complete
+ */
+int richacl_queue_drain(struct richacl_queue *q)
+{
+	while (q->q_n_free != q->q_depth) {
+		if (ring_reap(q, 1))
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * richacl_queue_teardown  -  free what richacl_queue_setup() allocated
+ */
+void richacl_queue_teardown(struct richacl_queue *q)
+{
+	if (q->q_ring)
+		ring_free(q->q_ring);
+	free(q->q_free);
+	free(q->q_buffers);
+	free(q->q_slots);
+}
@@ -0,0 +1,69 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <linux/xattr.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_queue_alloc  -  allocate a queue for reading and writing many acls
+ * @depth:	maximum number of requests in flight
+ * @name:	name of the xattr to use, or NULL for the richacl xattr
+ * @flags:	RICHACL_QUEUE_SYNC
+ * @done:	completion callback
+ *
+ * Requests are queued with richacl_queue_get_file(), richacl_queue_get_fd(),
+ * richacl_queue_set_file(), and richacl_queue_set_fd(), and are submitted
+ * to the kernel in batches through io_uring where available; @done is
+ * called as each request completes.  Without io_uring (or with
+ * RICHACL_QUEUE_SYNC), each request is carried out and completed before
+ * queuing it returns.
+ *
+ * A different @name such as "user.richacl" allows to use the queue on file
+ * systems without richacl support, for example for benchmarking.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_queue *richacl_queue_alloc(unsigned int depth, const char *name,
+					  int flags, richacl_queue_done_t done)
+{
+	struct richacl_queue *q;
+
+	if (!depth || !done || (flags & ~RICHACL_QUEUE_SYNC)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	q = calloc(1, sizeof(*q));
+	if (!q)
+		return NULL;
+	q->q_name = strdup(name ? name : XATTR_NAME_RICHACL);
+	if (!q->q_name)
+		goto fail;
+	q->q_done = done;
+	if (richacl_queue_setup(q, depth, !(flags & RICHACL_QUEUE_SYNC)))
+		goto fail;
+	return q;
+
+fail:
+	free(q->q_name);
+	free(q);
+	return NULL;
+}
@@ -0,0 +1,34 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_queue_get_fd  -  queue reading the acl of an open file
+ * @q:		queue from richacl_queue_alloc()
+ * @fd:		file descriptor; must remain open until the request completes
+ * @flags:	RICHACL_QUEUE_STAT
+ * @data:	argument for the completion callback
+ */
+int richacl_queue_get_fd(struct richacl_queue *q, int fd, int flags,
+			 void *data)
+{
+	return richacl_queue_push(q, RICHACL_QUEUE_GET, NULL, fd, NULL, flags,
+				  data);
+}
@@ -0,0 +1,127 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+static void set_masks(struct richacl *acl, unsigned int owner_mask,
+		      unsigned int group_mask, unsigned int other_mask)
+{
+	acl->a_owner_mask = owner_mask;
+	acl->a_group_mask = group_mask;
+	acl->a_other_mask = other_mask;
+}
+
+/**
+ * richacl_remask  -  apply masks to a prepared acl
+ * @remask:	acl from richacl_remask_alloc()
+ * @owner_mask:	owner file mask
+ * @group_mask:	group file mask
+ * @other_mask:	other file mask
+ *
+ * Returns the same as setting the file masks of the acl passed to
+ * richacl_remask_alloc(), setting RICHACL_MASKED, and calling
+ * richacl_apply_masks().  The everyone@ permissions are only propagated
+ * again when none of the recently used masks propagate the same
+ * permissions (see struct richacl_propagated).  @remask must not be used
+ * by several threads at the same time.
+ *
+ * Returns the new acl, or NULL with errno set on error.
+ */
+struct richacl *richacl_remask(struct richacl_remask *remask,
+			       unsigned int owner_mask,
+			       unsigned int group_mask,
+			       unsigned int other_mask)
+{
+	const struct richacl *normalized = remask->r_normalized;
+	unsigned int owner_allow = 0, group_allow = 0, other_allow = 0;
+	struct richacl_propagated *propagated, *victim;
+	struct richacl_alloc alloc;
+	unsigned int count;
+	int n;
+
+	/* What richacl_propagate_everyone() propagates with these masks */
+	if (normalized->a_count) {
+		const struct richace *ace =
+			normalized->a_entries + normalized->a_count - 1;
+
+		if (!richace_is_inherit_only(ace) && richace_is_everyone(ace)) {
+			owner_allow = ace->e_mask & owner_mask;
+			if (!(owner_allow & ~(group_mask & other_mask)))
+				owner_allow = 0;
+			group_allow = ace->e_mask & group_mask;
+			if (group_allow & ~other_mask)
+				other_allow = ace->e_mask & other_mask;
+			else
+				group_allow = 0;
+		}
+	}
+
+	victim = remask->r_propagated;
+	for (n = 0; n < RICHACL_REMASK_PROPAGATED; n++) {
+		propagated = remask->r_propagated + n;
+		if (propagated->p_acl &&
+		    propagated->p_owner_allow == owner_allow &&
+		    propagated->p_group_allow == group_allow &&
+		    propagated->p_other_allow == other_allow)
+			goto found;
+		if (!propagated->p_acl ||
+		    (victim->p_acl && propagated->p_used < victim->p_used))
+			victim = propagated;
+	}
+	propagated = victim;
+	alloc.acl = richacl_clone(normalized);
+	if (!alloc.acl)
+		return NULL;
+	alloc.count = alloc.acl->a_count;
+	set_masks(alloc.acl, owner_mask, group_mask, other_mask);
+	if (richacl_propagate_everyone(&alloc)) {
+		richacl_free(alloc.acl);
+		return NULL;
+	}
+	richacl_free(propagated->p_acl);
+	propagated->p_acl = alloc.acl;
+	propagated->p_owner_allow = owner_allow;
+	propagated->p_group_allow = group_allow;
+	propagated->p_other_allow = other_allow;
+
+found:
+	propagated->p_used = ++remask->r_clock;
+	alloc.acl = richacl_clone(propagated->p_acl);
+	if (!alloc.acl)
+		return NULL;
+	count = alloc.count = alloc.acl->a_count;
+	set_masks(alloc.acl, owner_mask, group_mask, other_mask);
+	alloc.acl->a_flags |= RICHACL_MASKED;
+	if (richacl_apply_masks_normalized(&alloc, remask->r_owner)) {
+		richacl_free(alloc.acl);
+		return NULL;
+	}
+	alloc.acl->a_flags &= ~(RICHACL_WRITE_THROUGH | RICHACL_MASKED);
+	if (alloc.count > count && alloc.count > alloc.acl->a_count) {
+		/* Give back the room needed during the transformation. */
+		struct richacl *acl2 = realloc(alloc.acl,
+			sizeof(struct richacl) +
+			alloc.acl->a_count * sizeof(struct richace));
+
+		if (acl2)
+			alloc.acl = acl2;
+	}
+	return alloc.acl;
+}
@@ -0,0 +1,62 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_remask_alloc  -  prepare an acl for applying different masks
+ * @acl:	acl to prepare
+ * @owner:	file owner
+ *
+ * Applying the masks (see richacl_apply_masks()) starts by moving the
+ * everyone@ entries to the end of the acl and by propagating the everyone@
+ * permissions up; these are the most expensive steps.  The first step does
+ * not depend on the masks, and the second one only depends on them in a
+ * limited way.  For acls whose masks change repeatedly, for example with
+ * chmod, richacl_remask() keeps the results of these steps and only repeats
+ * the remaining ones.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_remask *richacl_remask_alloc(const struct richacl *acl,
+					    uid_t owner)
+{
+	struct richacl_remask *remask;
+	struct richacl_alloc alloc;
+
+	remask = calloc(1, sizeof(*remask));
+	if (!remask)
+		return NULL;
+	alloc.acl = richacl_clone(acl);
+	if (!alloc.acl)
+		goto fail;
+	alloc.count = alloc.acl->a_count;
+	if (richacl_move_everyone_aces_down(&alloc)) {
+		richacl_free(alloc.acl);
+		goto fail;
+	}
+	remask->r_owner = owner;
+	remask->r_normalized = alloc.acl;
+	return remask;
+
+fail:
+	free(remask);
+	return NULL;
+}
@@ -0,0 +1,36 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_remask_free  -  free the result of richacl_remask_alloc()
+ */
+void richacl_remask_free(struct richacl_remask *remask)
+{
+	int n;
+
+	if (!remask)
+		return;
+	richacl_free(remask->r_normalized);
+	for (n = 0; n < RICHACL_REMASK_PROPAGATED; n++)
+		richacl_free(remask->r_propagated[n].p_acl);
+	free(remask);
+}
@@ -0,0 +1,48 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_reserve  -  make room for more entries in an acl
+ * @alloc:	acl and number of allocated entries
+ * @count:	number of entries needed
+ *
+ * Make sure that @alloc->acl has room for at least @count entries.  The
+ * allocation at least doubles each time it grows, so that adding entries
+ * one by one takes amortized constant time.
+ */
+int
+richacl_reserve(struct richacl_alloc *alloc, unsigned int count)
+{
+	struct richacl *acl2;
+
+	if (count <= alloc->count)
+		return 0;
+	if (count < 2 * alloc->count)
+		count = 2 * alloc->count;
+	acl2 = realloc(alloc->acl, sizeof(struct richacl) +
+				   count * sizeof(struct richace));
+	if (!acl2)
+		return -1;
+	alloc->acl = acl2;
+	alloc->count = count;
+	return 0;
+}
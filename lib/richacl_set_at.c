@@ -0,0 +1,42 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <alloca.h>
+#include <sys/types.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_set_at  -  set the acl of a file relative to a directory
+ * @dirfd:	directory file descriptor, or AT_FDCWD
+ * @name:	file name relative to @dirfd, or "" with AT_EMPTY_PATH
+ * @acl:	acl to set
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ *
+ * Like richacl_set_file(), but resolves @name like openat() and friends.
+ * Uses the setxattrat() system call where available.
+ */
+int richacl_set_at(int dirfd, const char *name, const struct richacl *acl,
+		   int flags)
+{
+	size_t size = richacl_xattr_size(acl);
+	void *value = alloca(size);
+
+	richacl_to_xattr(acl, value);
+	return richacl_setxattr_at(dirfd, name, flags, value, size);
+}
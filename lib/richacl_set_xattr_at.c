@@ -0,0 +1,40 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/types.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_set_xattr_at  -  set the acl of a file from an encoded xattr value
+ * @dirfd:	directory file descriptor, or AT_FDCWD
+ * @name:	file name relative to @dirfd, or "" with AT_EMPTY_PATH
+ * @value:	acl in xattr format, as produced by richacl_to_xattr()
+ * @size:	size of @value
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ *
+ * Like richacl_set_at(), but writes @value as it is, so that callers which
+ * already hold the encoded acl (for example, from richacl_to_xattr() or
+ * from another file) do not need to decode and encode it again.  The
+ * kernel checks that @value is a valid acl.
+ */
+int richacl_set_xattr_at(int dirfd, const char *name, const void *value,
+			 size_t size, int flags)
+{
+	return richacl_setxattr_at(dirfd, name, flags, value, size);
+}
@@ -0,0 +1,60 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+
+/**
+ * richacl_shape  -  classify an acl for richacl_permission_shape()
+ *
+ * Returns a combination of RICHACL_SHAPE_* flags which describe which
+ * features @acl uses:
+ *
+ * RICHACL_SHAPE_MASKED, RICHACL_SHAPE_WRITE_THROUGH:
+ *	the acl is masked, and the file masks are applied to all classes
+ * RICHACL_SHAPE_ALLOW_ONLY:
+ *	the acl has no deny entries (other than inherit-only entries)
+ * RICHACL_SHAPE_SPECIAL_ONLY:
+ *	the acl has no user or group entries (other than inherit-only
+ *	entries), as in acls equivalent to a file mode
+ * RICHACL_SHAPE_NO_INHERIT_ONLY:
+ *	the acl has no inherit-only entries
+ */
+unsigned int richacl_shape(const struct richacl *acl)
+{
+	const struct richace *ace;
+	unsigned int shape = RICHACL_SHAPE_ALLOW_ONLY |
+			     RICHACL_SHAPE_SPECIAL_ONLY |
+			     RICHACL_SHAPE_NO_INHERIT_ONLY;
+
+	if (acl->a_flags & RICHACL_MASKED) {
+		shape |= RICHACL_SHAPE_MASKED;
+		if (acl->a_flags & RICHACL_WRITE_THROUGH)
+			shape |= RICHACL_SHAPE_WRITE_THROUGH;
+	}
+	richacl_for_each_entry(ace, acl) {
+		if (richace_is_inherit_only(ace)) {
+			shape &= ~RICHACL_SHAPE_NO_INHERIT_ONLY;
+			continue;
+		}
+		if (!richace_is_allow(ace))
+			shape &= ~RICHACL_SHAPE_ALLOW_ONLY;
+		if (!(ace->e_flags & RICHACE_SPECIAL_WHO))
+			shape &= ~RICHACL_SHAPE_SPECIAL_ONLY;
+	}
+	return shape;
+}
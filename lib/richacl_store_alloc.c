@@ -0,0 +1,53 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_store_alloc  -  allocate a store of shared acls
+ *
+ * A store keeps one shared, immutable copy of each distinct acl passed to
+ * richacl_intern(), so that a program which holds the acls of many files
+ * only needs memory for the acls which differ, and can compare acls from
+ * the same store by comparing pointers.  The store can be shared between
+ * threads.
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl_store *richacl_store_alloc(void)
+{
+	struct richacl_store *store;
+	int n;
+
+	store = calloc(1, sizeof(*store));
+	if (!store)
+		return NULL;
+	for (n = 0; n < RICHACL_STORE_SHARDS; n++) {
+		errno = pthread_mutex_init(&store->s_shards[n].ss_lock, NULL);
+		if (errno) {
+			while (n--)
+				pthread_mutex_destroy(&store->s_shards[n].ss_lock);
+			free(store);
+			return NULL;
+		}
+	}
+	return store;
+}
@@ -0,0 +1,51 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_store_free  -  free a store and all the acls in it
+ *
+ * The acls from the store must no longer be used, even if references to
+ * them have not been dropped with richacl_intern_put().
+ */
+void richacl_store_free(struct richacl_store *store)
+{
+	int n;
+
+	if (!store)
+		return;
+	for (n = 0; n < RICHACL_STORE_SHARDS; n++) {
+		struct richacl_store_shard *shard = &store->s_shards[n];
+		unsigned int b;
+
+		for (b = 0; b < shard->ss_n_buckets; b++) {
+			struct richacl_interned *i, *next;
+
+			for (i = shard->ss_buckets[b]; i; i = next) {
+				next = i->i_next;
+				free(i);
+			}
+		}
+		free(shard->ss_buckets);
+		pthread_mutex_destroy(&shard->ss_lock);
+	}
+	free(store);
+}
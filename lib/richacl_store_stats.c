@@ -0,0 +1,49 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_store_stats  -  report how well a store shares acls
+ * @acls:	number of distinct acls in the store (or NULL)
+ * @hits:	number of richacl_intern() calls which found an identical
+ *		acl in the store (or NULL)
+ * @misses:	number of richacl_intern() calls which added an acl to the
+ *		store (or NULL)
+ */
+void richacl_store_stats(struct richacl_store *store, unsigned long *acls,
+			 unsigned long *hits, unsigned long *misses)
+{
+	unsigned long count = 0;
+	int n;
+
+	for (n = 0; n < RICHACL_STORE_SHARDS; n++) {
+		struct richacl_store_shard *shard = &store->s_shards[n];
+
+		pthread_mutex_lock(&shard->ss_lock);
+		count += shard->ss_count;
+		pthread_mutex_unlock(&shard->ss_lock);
+	}
+	if (acls)
+		*acls = count;
+	if (hits)
+		*hits = __atomic_load_n(&store->s_hits, __ATOMIC_RELAXED);
+	if (misses)
+		*misses = __atomic_load_n(&store->s_misses, __ATOMIC_RELAXED);
+}
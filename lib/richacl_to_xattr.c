@@ -21,6 +21,7 @@
 #include <string.h>
 #include <linux/richacl_xattr.h>
 #include "sys/richacl.h"
+#include "richacl-internal.h"
 #include "byteorder.h"
 
 void richacl_to_xattr(const struct richacl *acl, void *buffer)
@@ -40,18 +41,15 @@ void richacl_to_xattr(const struct richacl *acl, void *buffer)
 
 	xattr_ace = (void *)(xattr_acl + 1);
 	xattr_ids = (char *)(xattr_ace + acl->a_count);
+	if (!richacl_xattr_encode_entries(xattr_ace, acl->a_entries,
+					  acl->a_count))
+		return;
 	richacl_for_each_entry(ace, acl) {
-		xattr_ace->e_type = cpu_to_le16(ace->e_type);
-		xattr_ace->e_flags = cpu_to_le16(ace->e_flags &
-						 RICHACE_VALID_FLAGS);
-		xattr_ace->e_mask = cpu_to_le32(ace->e_mask);
-		xattr_ace->e_id = cpu_to_le32(ace->e_id);
 		if (ace->e_flags & RICHACE_UNMAPPED_WHO) {
 			size_t sz = strlen(ace->e_who) + 1;
 
 			memcpy(xattr_ids, ace->e_who, sz);
 			xattr_ids += sz;
 		}
-		xattr_ace++;
 	}
 }
@@ -0,0 +1,61 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_unpack  -  convert a packed acl back into a struct richacl
+ *
+ * Returns NULL and sets errno on error.
+ */
+struct richacl *richacl_unpack(const struct richacl_packed *packed)
+{
+	struct richacl *acl;
+	unsigned int n;
+
+	acl = richacl_alloc(packed->p_count);
+	if (!acl)
+		return NULL;
+	acl->a_flags = packed->p_flags;
+	acl->a_owner_mask = packed->p_owner_mask;
+	acl->a_group_mask = packed->p_group_mask;
+	acl->a_other_mask = packed->p_other_mask;
+	for (n = 0; n < packed->p_count; n++) {
+		struct richace *ace = &acl->a_entries[n];
+
+		ace->e_type = packed->p_types[n];
+		ace->e_mask = packed->p_masks[n];
+		if (packed->p_ace_flags[n] & RICHACE_UNMAPPED_WHO) {
+			ace->e_flags = packed->p_ace_flags[n] &
+				       ~RICHACE_UNMAPPED_WHO;
+			if (richace_set_unmapped_who(ace,
+					packed->p_who + packed->p_ids[n],
+					packed->p_ace_flags[n])) {
+				acl->a_count = n;
+				richacl_free(acl);
+				return NULL;
+			}
+			ace->e_flags = packed->p_ace_flags[n];
+		} else {
+			ace->e_flags = packed->p_ace_flags[n];
+			ace->e_id = packed->p_ids[n];
+		}
+	}
+	return acl;
+}
@@ -0,0 +1,263 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+
+#include <sys/types.h>
+#include <sys/xattr.h>
+#include <sys/syscall.h>
+#include <linux/xattr.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/*
+ * The getxattrat() and setxattrat() system calls were added in Linux 6.13;
+ * their numbers are the same on all architectures using the generic system
+ * call table.
+ */
+#if !defined(SYS_getxattrat) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+#define SYS_setxattrat 463
+#define SYS_getxattrat 464
+#endif
+
+/* Same layout as struct xattr_args in <linux/xattr.h>. */
+struct richacl_xattr_args {
+	uint64_t value;
+	uint32_t size;
+	uint32_t flags;
+};
+
+#ifdef SYS_getxattrat
+/* Set once the kernel turns out not to support the *xattrat() calls. */
+static int xattrat_missing;
+#endif
+
+#define PROC_FD_PATH_SIZE (sizeof("/proc/self/fd/") + 3 * sizeof(int))
+
+/*
+ * Without the *xattrat() calls, open @name with O_PATH and get at the file
+ * through /proc/self/fd/, which works for files of any type and without
+ * read or write access.  Returns the O_PATH file descriptor which the
+ * caller needs to close, or -1.
+ */
+static int open_at(int dirfd, const char *name, int flags, char *proc_path)
+{
+	int fd;
+
+	fd = openat(dirfd, name, O_PATH | O_CLOEXEC |
+			((flags & AT_SYMLINK_NOFOLLOW) ? O_NOFOLLOW : 0));
+	if (fd >= 0)
+		snprintf(proc_path, PROC_FD_PATH_SIZE, "/proc/self/fd/%d", fd);
+	return fd;
+}
+
+/*
+ * File descriptors opened with O_PATH do not support f*xattr(), and the
+ * *xattrat() calls reject them with AT_EMPTY_PATH as well.
+ */
+static bool is_path_fd(int fd)
+{
+	int flags = fcntl(fd, F_GETFL);
+
+	return flags >= 0 && (flags & O_PATH);
+}
+
+static void close_fd(int fd)
+{
+	int saved_errno = errno;
+
+	close(fd);
+	errno = saved_errno;
+}
+
+#ifdef SYS_getxattrat
+/*
+ * The *xattrat() calls are unsupported when they fail with ENOSYS, or with
+ * EPERM when a seccomp filter which does not know about them blocks them.
+ * Also retry EBADF for an empty @name; see is_path_fd().
+ */
+static bool retry_without_xattrat(const char *name)
+{
+	return errno == ENOSYS || errno == EPERM || (errno == EBADF && !*name);
+}
+
+/*
+ * Remember when the *xattrat() calls are unsupported, given the result of
+ * the fallback in @ret and errno.  Setting an xattr can fail with EPERM for
+ * real, so EPERM only counts when the fallback did not fail with EPERM too.
+ */
+static void xattrat_failed(int xattrat_errno, ssize_t ret)
+{
+	if (xattrat_errno == ENOSYS ||
+	    (xattrat_errno == EPERM && (ret >= 0 || errno != EPERM)))
+		__atomic_store_n(&xattrat_missing, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+/* Emulate getxattrat() with the path based calls. */
+static ssize_t getxattr_fallback(int dirfd, const char *name, int flags,
+				 void *value, size_t size)
+{
+	char proc_path[PROC_FD_PATH_SIZE];
+	ssize_t ret;
+	int fd;
+
+	if (!*name) {
+		if (!(flags & AT_EMPTY_PATH)) {
+			errno = ENOENT;
+			return -1;
+		}
+		if (dirfd == AT_FDCWD)
+			return getxattr(".", XATTR_NAME_RICHACL, value, size);
+		ret = fgetxattr(dirfd, XATTR_NAME_RICHACL, value, size);
+		if (ret >= 0 || errno != EBADF || !is_path_fd(dirfd))
+			return ret;
+		snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", dirfd);
+		return getxattr(proc_path, XATTR_NAME_RICHACL, value, size);
+	}
+	if (dirfd == AT_FDCWD || *name == '/') {
+		if (flags & AT_SYMLINK_NOFOLLOW)
+			return lgetxattr(name, XATTR_NAME_RICHACL, value, size);
+		return getxattr(name, XATTR_NAME_RICHACL, value, size);
+	}
+	fd = open_at(dirfd, name, flags, proc_path);
+	if (fd < 0)
+		return -1;
+	ret = getxattr(proc_path, XATTR_NAME_RICHACL, value, size);
+	close_fd(fd);
+	return ret;
+}
+
+/* Emulate setxattrat() with the path based calls. */
+static int setxattr_fallback(int dirfd, const char *name, int flags,
+			     const void *value, size_t size)
+{
+	char proc_path[PROC_FD_PATH_SIZE];
+	int fd, ret;
+
+	if (!*name) {
+		if (!(flags & AT_EMPTY_PATH)) {
+			errno = ENOENT;
+			return -1;
+		}
+		if (dirfd == AT_FDCWD)
+			return setxattr(".", XATTR_NAME_RICHACL, value, size, 0);
+		ret = fsetxattr(dirfd, XATTR_NAME_RICHACL, value, size, 0);
+		if (ret >= 0 || errno != EBADF || !is_path_fd(dirfd))
+			return ret;
+		snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", dirfd);
+		return setxattr(proc_path, XATTR_NAME_RICHACL, value, size, 0);
+	}
+	if (dirfd == AT_FDCWD || *name == '/') {
+		if (flags & AT_SYMLINK_NOFOLLOW)
+			return lsetxattr(name, XATTR_NAME_RICHACL, value, size, 0);
+		return setxattr(name, XATTR_NAME_RICHACL, value, size, 0);
+	}
+	fd = open_at(dirfd, name, flags, proc_path);
+	if (fd < 0)
+		return -1;
+	ret = setxattr(proc_path, XATTR_NAME_RICHACL, value, size, 0);
+	close_fd(fd);
+	return ret;
+}
+
+/**
+ * richacl_getxattr_at  -  read the richacl xattr of a file relative to a directory
+ * @dirfd:	directory file descriptor, or AT_FDCWD
+ * @name:	file name relative to @dirfd, or "" with AT_EMPTY_PATH
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ * @value:	buffer for the xattr value
+ * @size:	size of @value, or 0 to determine the size of the value
+ *
+ * Returns what getxattr() would return.
+ */
+ssize_t richacl_getxattr_at(int dirfd, const char *name, int flags,
+			    void *value, size_t size)
+{
+	if (flags & ~(AT_SYMLINK_NOFOLLOW | AT_EMPTY_PATH)) {
+		errno = EINVAL;
+		return -1;
+	}
+#ifdef SYS_getxattrat
+	if (!__atomic_load_n(&xattrat_missing, __ATOMIC_RELAXED)) {
+		struct richacl_xattr_args args = {
+			.value = (uintptr_t)value,
+			.size = size,
+		};
+		int xattrat_errno;
+		ssize_t ret;
+
+		ret = syscall(SYS_getxattrat, dirfd, name, flags,
+			      XATTR_NAME_RICHACL, &args, sizeof(args));
+		if (ret >= 0 || !retry_without_xattrat(name))
+			return ret;
+		xattrat_errno = errno;
+		ret = getxattr_fallback(dirfd, name, flags, value, size);
+		xattrat_failed(xattrat_errno, ret);
+		return ret;
+	}
+#endif
+	return getxattr_fallback(dirfd, name, flags, value, size);
+}
+
+/**
+ * richacl_setxattr_at  -  set the richacl xattr of a file relative to a directory
+ * @dirfd:	directory file descriptor, or AT_FDCWD
+ * @name:	file name relative to @dirfd, or "" with AT_EMPTY_PATH
+ * @flags:	AT_SYMLINK_NOFOLLOW and/or AT_EMPTY_PATH
+ * @value:	xattr value
+ * @size:	size of @value
+ *
+ * Returns what setxattr() would return.
+ */
+int richacl_setxattr_at(int dirfd, const char *name, int flags,
+			const void *value, size_t size)
+{
+	if (flags & ~(AT_SYMLINK_NOFOLLOW | AT_EMPTY_PATH)) {
+		errno = EINVAL;
+		return -1;
+	}
+#ifdef SYS_setxattrat
+	if (!__atomic_load_n(&xattrat_missing, __ATOMIC_RELAXED)) {
+		struct richacl_xattr_args args = {
+			.value = (uintptr_t)value,
+			.size = size,
+		};
+		int xattrat_errno, ret;
+
+		ret = syscall(SYS_setxattrat, dirfd, name, flags,
+			      XATTR_NAME_RICHACL, &args, sizeof(args));
+		if (ret >= 0 || !retry_without_xattrat(name))
+			return ret;
+		xattrat_errno = errno;
+		ret = setxattr_fallback(dirfd, name, flags, value, size);
+		xattrat_failed(xattrat_errno, ret);
+		return ret;
+	}
+#endif
+	return setxattr_fallback(dirfd, name, flags, value, size);
+}
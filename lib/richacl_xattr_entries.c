@@ -0,0 +1,273 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <linux/richacl_xattr.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+#include "byteorder.h"
+
+/* The AVX2 code relies on the layout of struct richace on x86_64. */
+#if HAVE_AVX2 && defined(__x86_64__) && defined(RICHACL_XATTR_NATIVE)
+# define USE_AVX2 1
+# include <immintrin.h>
+#endif
+
+#ifdef RICHACL_XATTR_NATIVE
+_Static_assert(offsetof(struct richace, e_flags) ==
+	       offsetof(struct richace_xattr, e_flags) &&
+	       offsetof(struct richace, e_mask) ==
+	       offsetof(struct richace_xattr, e_mask) &&
+	       offsetof(struct richace, e_id) == 8 &&
+	       offsetof(struct richace_xattr, e_id) == 8,
+	       "struct richace and struct richace_xattr differ");
+#endif
+
+static int decode_entries_scalar(struct richace *ace,
+				 const struct richace_xattr *xattr_ace,
+				 unsigned int count)
+{
+	unsigned int n, unmapped = 0, invalid = 0;
+
+	for (n = 0; n < count; n++) {
+#ifdef RICHACL_XATTR_NATIVE
+		memcpy(&ace[n], &xattr_ace[n], offsetof(struct richace, e_id));
+		memcpy(&ace[n].e_id, &xattr_ace[n].e_id, sizeof(ace[n].e_id));
+#else
+		ace[n].e_type = xattr_le16_to_cpu(xattr_ace[n].e_type);
+		ace[n].e_flags = xattr_le16_to_cpu(xattr_ace[n].e_flags);
+		ace[n].e_mask = xattr_le32_to_cpu(xattr_ace[n].e_mask);
+		ace[n].e_id = xattr_le32_to_cpu(xattr_ace[n].e_id);
+#endif
+		invalid |= !!(ace[n].e_flags & RICHACE_SPECIAL_WHO) &
+			   (ace[n].e_id > RICHACE_EVERYONE_SPECIAL_ID);
+		unmapped += !!(ace[n].e_flags & RICHACE_UNMAPPED_WHO);
+	}
+	if (invalid) {
+		errno = EINVAL;
+		return -1;
+	}
+	return unmapped;
+}
+
+static unsigned int encode_entries_scalar(struct richace_xattr *xattr_ace,
+					  const struct richace *ace,
+					  unsigned int count)
+{
+	unsigned int n, unmapped = 0;
+
+	for (n = 0; n < count; n++) {
+#ifdef RICHACL_XATTR_NATIVE
+		unsigned long long head;
+
+		memcpy(&head, &ace[n], sizeof(head));
+		/* Clear the invalid flags in e_flags (bytes 2 and 3). */
+		head &= ~((unsigned long long)(0xffff & ~RICHACE_VALID_FLAGS)
+			  << 16);
+		memcpy(&xattr_ace[n], &head, sizeof(head));
+		memcpy(&xattr_ace[n].e_id, &ace[n].e_id,
+		       sizeof(xattr_ace[n].e_id));
+#else
+		unsigned char *p = (unsigned char *)&xattr_ace[n];
+		unsigned int flags = ace[n].e_flags & RICHACE_VALID_FLAGS;
+
+		p[0] = ace[n].e_type;
+		p[1] = ace[n].e_type >> 8;
+		p[2] = flags;
+		p[3] = flags >> 8;
+		p[4] = ace[n].e_mask;
+		p[5] = ace[n].e_mask >> 8;
+		p[6] = ace[n].e_mask >> 16;
+		p[7] = ace[n].e_mask >> 24;
+		p[8] = ace[n].e_id;
+		p[9] = ace[n].e_id >> 8;
+		p[10] = ace[n].e_id >> 16;
+		p[11] = ace[n].e_id >> 24;
+#endif
+		unmapped += !!(ace[n].e_flags & RICHACE_UNMAPPED_WHO);
+	}
+	return unmapped;
+}
+
+#ifdef USE_AVX2
+/*
+ * In a 256-bit register, each 128-bit lane holds one struct richace: type
+ * and flags in dword 0, the mask in dword 1, and the identifier in dword 2.
+ * Dword 3 is the upper half of the e_id / e_who union.
+ */
+#define LANES(a, b, c, d) _mm256_setr_epi32(a, b, c, d, a, b, c, d)
+
+/* Count the entries in @v with an unmapped identifier into @unmapped. */
+__attribute__((target("avx2")))
+static inline __m256i count_unmapped_avx2(__m256i v, __m256i unmapped)
+{
+	const __m256i unmapped_who = LANES(RICHACE_UNMAPPED_WHO << 16, 0, 0, 0);
+
+	/* RICHACE_UNMAPPED_WHO << 16 is bit 29. */
+	return _mm256_add_epi32(unmapped,
+		_mm256_srli_epi32(_mm256_and_si256(v, unmapped_who), 29));
+}
+
+/* Flag the special identifiers in @v which are out of range in @invalid. */
+__attribute__((target("avx2")))
+static inline __m256i check_special_avx2(__m256i v, __m256i invalid)
+{
+	const __m256i special_who = LANES(RICHACE_SPECIAL_WHO << 16, 0, 0, 0);
+	const __m256i max_id = _mm256_set1_epi32(RICHACE_EVERYONE_SPECIAL_ID);
+	__m256i id, id_valid;
+
+	/* All dwords of a lane set to the identifier. */
+	id = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 2, 2));
+	id_valid = _mm256_cmpeq_epi32(_mm256_min_epu32(id, max_id), id);
+	return _mm256_or_si256(invalid,
+		_mm256_andnot_si256(id_valid, _mm256_and_si256(v, special_who)));
+}
+
+__attribute__((target("avx2")))
+static unsigned int sum_lanes_avx2(__m256i v)
+{
+	return _mm256_extract_epi32(v, 0) + _mm256_extract_epi32(v, 4);
+}
+
+/*
+ * Decode four entries (48 bytes) at a time: two overlapping 32-byte loads
+ * hold entries 0 and 1 and entries 2 and 3, which a permutation spreads
+ * out into the 16-byte struct richace layout.
+ */
+__attribute__((target("avx2")))
+static int decode_entries_avx2(struct richace *ace,
+			       const struct richace_xattr *xattr_ace,
+			       unsigned int count)
+{
+	const __m256i first = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+	const __m256i second = _mm256_setr_epi32(2, 3, 4, 0, 5, 6, 7, 0);
+	__m256i unmapped = _mm256_setzero_si256();
+	__m256i invalid = _mm256_setzero_si256();
+	unsigned int n;
+	int tail;
+
+	for (n = 0; n + 4 <= count; n += 4) {
+		const char *p = (const char *)&xattr_ace[n];
+		__m256i a, b;
+
+		a = _mm256_loadu_si256((const __m256i *)p);
+		b = _mm256_loadu_si256((const __m256i *)(p + 16));
+		a = _mm256_permutevar8x32_epi32(a, first);
+		b = _mm256_permutevar8x32_epi32(b, second);
+		/* Clear the upper half of the e_id / e_who union. */
+		a = _mm256_blend_epi32(a, _mm256_setzero_si256(), 0x88);
+		b = _mm256_blend_epi32(b, _mm256_setzero_si256(), 0x88);
+		unmapped = count_unmapped_avx2(a, unmapped);
+		unmapped = count_unmapped_avx2(b, unmapped);
+		invalid = check_special_avx2(a, invalid);
+		invalid = check_special_avx2(b, invalid);
+		_mm256_storeu_si256((__m256i *)&ace[n], a);
+		_mm256_storeu_si256((__m256i *)&ace[n + 2], b);
+	}
+	if (!_mm256_testz_si256(invalid, invalid)) {
+		errno = EINVAL;
+		return -1;
+	}
+	tail = decode_entries_scalar(ace + n, xattr_ace + n, count - n);
+	if (tail < 0)
+		return -1;
+	return sum_lanes_avx2(unmapped) + tail;
+}
+
+/* The reverse of decode_entries_avx2(). */
+__attribute__((target("avx2")))
+static unsigned int encode_entries_avx2(struct richace_xattr *xattr_ace,
+					const struct richace *ace,
+					unsigned int count)
+{
+	const __m256i valid = LANES(0xffff | (RICHACE_VALID_FLAGS << 16),
+				    -1, -1, 0);
+	const __m256i first = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 0, 0);
+	const __m256i second = _mm256_setr_epi32(2, 4, 5, 6, 0, 0, 0, 1);
+	__m256i unmapped = _mm256_setzero_si256();
+	unsigned int n;
+
+	for (n = 0; n + 4 <= count; n += 4) {
+		char *p = (char *)&xattr_ace[n];
+		__m256i a, b;
+
+		a = _mm256_loadu_si256((const __m256i *)&ace[n]);
+		b = _mm256_loadu_si256((const __m256i *)&ace[n + 2]);
+		unmapped = count_unmapped_avx2(a, unmapped);
+		unmapped = count_unmapped_avx2(b, unmapped);
+		a = _mm256_and_si256(a, valid);
+		b = _mm256_and_si256(b, valid);
+		a = _mm256_permutevar8x32_epi32(a, first);
+		b = _mm256_permutevar8x32_epi32(b, second);
+		/* Entries 0, 1 and the first two dwords of entry 2 ... */
+		_mm256_storeu_si256((__m256i *)p,
+				    _mm256_blend_epi32(a, b, 0xc0));
+		/* ... and the rest of entry 2 and entry 3. */
+		_mm_storeu_si128((__m128i *)(p + 32),
+				 _mm256_castsi256_si128(b));
+	}
+	return sum_lanes_avx2(unmapped) +
+	       encode_entries_scalar(xattr_ace + n, ace + n, count - n);
+}
+#endif  /* USE_AVX2 */
+
+/**
+ * richacl_xattr_decode_entries  -  decode the fixed-size part of entries
+ * @ace:	first entry to decode into
+ * @xattr_ace:	first entry to decode
+ * @count:	number of entries
+ *
+ * Also checks that the special identifiers are valid.  The e_who fields
+ * of entries with an unmapped identifier are not set up.
+ *
+ * Returns the number of entries with an unmapped identifier, or -1 with
+ * errno set to EINVAL.
+ */
+int richacl_xattr_decode_entries(struct richace *ace,
+				 const struct richace_xattr *xattr_ace,
+				 unsigned int count)
+{
+#ifdef USE_AVX2
+	if (count >= 4 && __builtin_cpu_supports("avx2"))
+		return decode_entries_avx2(ace, xattr_ace, count);
+#endif
+	return decode_entries_scalar(ace, xattr_ace, count);
+}
+
+/**
+ * richacl_xattr_encode_entries  -  encode the fixed-size part of entries
+ * @xattr_ace:	first entry to encode into
+ * @ace:	first entry to encode
+ * @count:	number of entries
+ *
+ * Returns the number of entries with an unmapped identifier; their
+ * identifiers are not encoded.
+ */
+unsigned int richacl_xattr_encode_entries(struct richace_xattr *xattr_ace,
+					  const struct richace *ace,
+					  unsigned int count)
+{
+#ifdef USE_AVX2
+	if (count >= 4 && __builtin_cpu_supports("avx2"))
+		return encode_entries_avx2(xattr_ace, ace, count);
+#endif
+	return encode_entries_scalar(xattr_ace, ace, count);
+}
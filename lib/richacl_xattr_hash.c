@@ -0,0 +1,63 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <linux/richacl_xattr.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+#include "byteorder.h"
+
+/**
+ * richacl_xattr_hash  -  content hash of an xattr value
+ * @value:	xattr value
+ * @size:	size of @value
+ * @hash:	the hash (output)
+ *
+ * Computes the same hash as richacl_hash() of the decoded acl, without
+ * decoding it.
+ *
+ * Returns 0, or -1 with errno set to EINVAL if @value is not a valid
+ * richacl xattr.
+ */
+int richacl_xattr_hash(const void *value, size_t size, uint64_t *hash)
+{
+	const struct richacl_xattr *xattr_acl = value;
+	const struct richace_xattr *xattr_ace = (void *)(xattr_acl + 1);
+	struct richacl_xattr_view view;
+	const char *who;
+	uint64_t h;
+	unsigned int n;
+
+	if (richacl_xattr_view_init(&view, value, size))
+		return -1;
+	h = richacl_hash_header(view.v_flags, view.v_count,
+				view.v_owner_mask, view.v_group_mask,
+				view.v_other_mask);
+	who = view.v_who;
+	for (n = 0; n < view.v_count; n++, xattr_ace++) {
+		unsigned int flags = le16_to_cpu(xattr_ace->e_flags);
+
+		h = richacl_hash_entry(h, le16_to_cpu(xattr_ace->e_type),
+				       flags, le32_to_cpu(xattr_ace->e_mask),
+				       le32_to_cpu(xattr_ace->e_id), who);
+		if (flags & RICHACE_UNMAPPED_WHO)
+			who += strlen(who) + 1;
+	}
+	*hash = h;
+	return 0;
+}
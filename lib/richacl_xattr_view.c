@@ -0,0 +1,121 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <errno.h>
+#include <linux/richacl_xattr.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+#include "byteorder.h"
+
+/**
+ * richacl_xattr_view_init  -  check an xattr value for use without decoding
+ * @view:	view to initialize
+ * @value:	xattr value
+ * @size:	size of @value
+ *
+ * Checks @value in a single pass and without allocating memory.  Exactly
+ * the values which richacl_from_xattr() accepts are accepted.  @value must
+ * remain valid and unchanged for as long as @view is used.
+ *
+ * Returns 0, or -1 with errno set to EINVAL if @value is not a valid
+ * richacl xattr.
+ */
+int richacl_xattr_view_init(struct richacl_xattr_view *view,
+			    const void *value, size_t size)
+{
+	const struct richacl_xattr *xattr_acl = value;
+	const struct richace_xattr *xattr_ace = (void *)(xattr_acl + 1);
+	const char *xattr_ids;
+	int count, n;
+
+	count = richacl_xattr_count(value, size);
+	if (count < 0)
+		return -1;
+	size -= sizeof(*xattr_acl) + count * sizeof(*xattr_ace);
+	xattr_ids = (const char *)(xattr_ace + count);
+	if (size && xattr_ids[size - 1] != 0)
+		goto fail_einval;
+
+	view->v_value = value;
+	view->v_who = xattr_ids;
+	view->v_flags = xattr_acl->a_flags;
+	view->v_count = count;
+	view->v_owner_mask = le32_to_cpu(xattr_acl->a_owner_mask);
+	view->v_group_mask = le32_to_cpu(xattr_acl->a_group_mask);
+	view->v_other_mask = le32_to_cpu(xattr_acl->a_other_mask);
+
+	for (n = 0; n < count; n++, xattr_ace++) {
+		unsigned short flags = le16_to_cpu(xattr_ace->e_flags);
+
+		if (flags & RICHACE_SPECIAL_WHO &&
+		    le32_to_cpu(xattr_ace->e_id) > RICHACE_EVERYONE_SPECIAL_ID)
+			goto fail_einval;
+		if (flags & RICHACE_UNMAPPED_WHO) {
+			size_t sz;
+
+			if (!size)
+				goto fail_einval;
+			sz = strlen(xattr_ids) + 1;
+			xattr_ids += sz;
+			size -= sz;
+		}
+	}
+	if (size != 0)
+		goto fail_einval;
+	return 0;
+
+fail_einval:
+	errno = EINVAL;
+	return -1;
+}
+
+/**
+ * richacl_xattr_view_entry  -  look at an entry of an xattr value
+ * @view:	view from richacl_xattr_view_init()
+ * @n:		index of the entry, less than @view->v_count
+ * @ace:	filled in with the entry
+ *
+ * For entries with an unmapped identifier, @ace->e_who points into the
+ * xattr value, so @ace must not be passed to any function that frees or
+ * modifies the identifier.  Finding the identifier takes time proportional
+ * to the number of unmapped entries before @n; the identifiers of all
+ * other entries are found in constant time.
+ */
+void richacl_xattr_view_entry(const struct richacl_xattr_view *view,
+			      unsigned int n, struct richace *ace)
+{
+	const struct richace_xattr *xattr_ace =
+		(const void *)((const struct richacl_xattr *)view->v_value + 1);
+
+	ace->e_type = le16_to_cpu(xattr_ace[n].e_type);
+	ace->e_flags = le16_to_cpu(xattr_ace[n].e_flags);
+	ace->e_mask = le32_to_cpu(xattr_ace[n].e_mask);
+	if (ace->e_flags & RICHACE_UNMAPPED_WHO) {
+		const char *who = view->v_who;
+		unsigned int k;
+
+		for (k = 0; k < n; k++) {
+			if (le16_to_cpu(xattr_ace[k].e_flags) &
+			    RICHACE_UNMAPPED_WHO)
+				who += strlen(who) + 1;
+		}
+		ace->e_who = (char *)who;
+	} else
+		ace->e_id = le32_to_cpu(xattr_ace[n].e_id);
+}
@@ -0,0 +1,54 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/stat.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+
+/**
+ * richacl_xattr_view_access  -  Determine the permissions of a process
+ * @view:	xattr value of the file, from richacl_xattr_view_init()
+ * @st:		status of the file
+ * @cred:	user and groups to check permissions for
+ *
+ * Returns the permissions which the acl in @view grants to a process with
+ * credentials @cred, like richacl_access_cred() would for a file with that
+ * acl, without decoding the acl or allocating memory.
+ */
+int richacl_xattr_view_access(const struct richacl_xattr_view *view,
+			      const struct stat *st,
+			      const struct richacl_cred *cred)
+{
+	int in_owning_group = richacl_cred_in_group(cred, st->st_gid);
+	struct richacl_eval ev;
+	unsigned int allowed;
+
+	if (!richacl_eval_init(&ev, view->v_flags, view->v_owner_mask,
+			       view->v_group_mask, view->v_other_mask,
+			       cred->cr_uid == st->st_uid, in_owning_group,
+			       RICHACE_VALID_MASK, 0))
+		richacl_xattr_view_eval(view, st->st_uid, in_owning_group,
+					cred, &ev);
+	allowed = richacl_eval_mask(&ev);
+
+	/* RICHACE_DELETE_CHILD is meaningless for non-directories. */
+	if (!S_ISDIR(st->st_mode))
+		allowed &= ~RICHACE_DELETE_CHILD;
+
+	return allowed;
+}
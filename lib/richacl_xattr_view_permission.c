@@ -0,0 +1,86 @@
+/*
+  Copyright (C) 2015  Red Hat, Inc.
+
+  The richacl library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation; either version 2.1 of the
+  License, or (at your option) any later version.
+
+  The richacl library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <linux/richacl_xattr.h>
+#include "sys/richacl.h"
+#include "richacl-internal.h"
+#include "byteorder.h"
+
+/**
+ * richacl_xattr_view_eval  -  evaluate the acl in an xattr view
+ * @view:	xattr value of the file, from richacl_xattr_view_init()
+ * @owner:	Owner of the file
+ * @in_owning_group: the process is in the owning group of the file
+ * @cred:	User and groups of the accessing process
+ * @ev:		evaluation started with richacl_eval_init()
+ *
+ * Applies the entries of @view which match the process to @ev, without
+ * decoding the acl.
+ */
+void richacl_xattr_view_eval(const struct richacl_xattr_view *view,
+			     uid_t owner, bool in_owning_group,
+			     const struct richacl_cred *cred,
+			     struct richacl_eval *ev)
+{
+	const struct richace_xattr *xattr_ace =
+		(const void *)((const struct richacl_xattr *)view->v_value + 1);
+	unsigned int n;
+
+	for (n = 0; n < view->v_count; n++, xattr_ace++) {
+		struct richace ace;
+		unsigned int class;
+
+		/* The identifier of unmapped entries is not needed here. */
+		ace.e_type = le16_to_cpu(xattr_ace->e_type);
+		ace.e_flags = le16_to_cpu(xattr_ace->e_flags);
+		ace.e_id = le32_to_cpu(xattr_ace->e_id);
+		class = richacl_eval_match(&ace, owner, in_owning_group, cred);
+		if (class != RICHACE_CLASS_INVALID &&
+		    richacl_eval_entry(ev, class, ace.e_type,
+				       le32_to_cpu(xattr_ace->e_mask)))
+			break;
+	}
+}
+
+/**
+ * richacl_xattr_view_permission  -  check if a process has the requested access
+ * @view:	xattr value of the file to check, from richacl_xattr_view_init()
+ * @owner:	Owner of the file
+ * @owning_group: Owning group of the file
+ * @cred:	User and groups of the accessing process
+ * @mask:	Requested permissions (RICHACE_* mask flags)
+ *
+ * Returns what richacl_permission_cred() would return for the decoded acl,
+ * without decoding the acl or allocating memory.
+ */
+bool richacl_xattr_view_permission(const struct richacl_xattr_view *view,
+				   uid_t owner, gid_t owning_group,
+				   const struct richacl_cred *cred,
+				   unsigned int mask)
+{
+	int in_owning_group = richacl_cred_in_group(cred, owning_group);
+	struct richacl_eval ev;
+
+	if (!richacl_eval_init(&ev, view->v_flags, view->v_owner_mask,
+			       view->v_group_mask, view->v_other_mask,
+			       cred->cr_uid == owner, in_owning_group,
+			       mask, mask))
+		richacl_xattr_view_eval(view, owner, in_owning_group, cred,
+					&ev);
+	return richacl_eval_granted(&ev);
+}
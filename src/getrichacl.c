@@ -42,6 +42,7 @@
 #include "sys/richacl.h"
 #include "string_buffer.h"
 #include "common.h"
+#include "user_group.h"
 
 static const char *progname;
 
@@ -53,16 +54,31 @@ int format_for_mode(mode_t mode)
 		return RICHACL_TEXT_FILE_CONTEXT;
 }
 
+/*
+ * Many files usually share the same few acls; with --cache-masks, remember
+ * the results of applying the file masks.
+ */
+static struct richacl_store *masks_store;
+static struct richacl_masks_cache *masks_cache;
+
 static int print_richacl(const char *file, struct richacl **acl,
 			 struct stat *st, int fmt)
 {
+	const struct richacl *masked = NULL;
 	char *text;
 
 	if (!(fmt & RICHACL_TEXT_SHOW_MASKS)) {
-		if (richacl_apply_masks(acl, st->st_uid))
+		if (masks_cache) {
+			masked = richacl_apply_masks_cache(masks_cache, *acl,
+							   st->st_uid);
+			if (!masked)
+				goto fail;
+		} else if (richacl_apply_masks(acl, st->st_uid))
 			goto fail;
 	}
-	text = richacl_to_text(*acl, fmt | format_for_mode(st->st_mode));
+	text = richacl_to_text(masked ? masked : *acl,
+			       fmt | format_for_mode(st->st_mode));
+	richacl_intern_put(masked);
 	if (!text)
 		goto fail;
 	printf("%s:\n", file);
@@ -74,13 +90,85 @@ fail:
 	return -1;
 }
 
+/*
+ * Returns the identifier of @row, and sets @prefix to what goes before it.
+ * User and group names can be of any length, so they are not formatted into
+ * a buffer.
+ */
+static const char *effective_who(const struct richacl_effective *row,
+				 int fmt, const char **prefix)
+{
+	*prefix = "";
+	if (row->e_flags & RICHACE_SPECIAL_WHO) {
+		switch (row->e_id) {
+		case RICHACE_OWNER_SPECIAL_ID:
+			return "owner@";
+		case RICHACE_GROUP_SPECIAL_ID:
+			return "group@";
+		default:
+			return "everyone@";
+		}
+	} else if (row->e_flags & RICHACE_IDENTIFIER_GROUP) {
+		*prefix = "group:";
+		return group_name(row->e_id, fmt & RICHACL_TEXT_NUMERIC_IDS);
+	} else {
+		*prefix = "user:";
+		return user_name(row->e_id, fmt & RICHACL_TEXT_NUMERIC_IDS);
+	}
+}
+
+static int print_effective(const char *file, const struct richacl *acl,
+			   struct stat *st, int fmt)
+{
+	struct richacl_effective *matrix;
+	unsigned int count, n;
+	const char *prefix, *who;
+	int align = 0;
+
+	matrix = richacl_effective(acl, st, &count);
+	if (!matrix)
+		return -1;
+	if (fmt & RICHACL_TEXT_ALIGN) {
+		for (n = 0; n < count; n++) {
+			int a;
+
+			who = effective_who(&matrix[n], fmt, &prefix);
+			a = strlen(prefix) + strlen(who);
+			if (a >= align)
+				align = a + 1;
+		}
+	}
+	printf("%s:\n", file);
+	for (n = 0; n < count; n++) {
+		char *mask_text;
+		int pad;
+
+		mask_text = richacl_mask_to_text(matrix[n].e_mask,
+				fmt | format_for_mode(st->st_mode));
+		if (!mask_text) {
+			free(matrix);
+			return -1;
+		}
+		who = effective_who(&matrix[n], fmt, &prefix);
+		pad = align - (int)(strlen(prefix) + strlen(who));
+		printf("%*s%s%s:%s\n", pad > 0 ? pad : 0, "", prefix, who,
+		       *mask_text ? mask_text : "-");
+		free(mask_text);
+	}
+	putchar('\n');
+	free(matrix);
+	return 0;
+}
+
 static struct option long_options[] = {
 	{"access",		2, 0, 'a'},
+	{"effective",		0, 0, 'e'},
 	{"long",		0, 0, 'l'},
 	{"raw",			0, 0,  2 },
 	{"full",                0, 0,  3 },
 	{"unaligned",		0, 0,  4 },
 	{"numeric-ids",		0, 0,  5 },
+	{"cache-masks",		0, 0,  6 },
 	{"version",		0, 0, 'v'},
 	{"help",		0, 0, 'h'},
 	{ NULL,			0, 0,  0 }
@@ -108,10 +196,17 @@ static void synopsis(int help)
 "              Do not align acl entries or pad missing permissions with '-'.\n"
 "  --numeric-ids\n"
 "              Display numeric user and group IDs instead of names.\n"
+"  --cache-masks\n"
+"              Remember the results of applying the file masks, which speeds\n"
+"              up listing many files with the same acls and owners.\n"
 "  --access[=user[:group:...]}, -a[user[:group:...]}\n"
 "              Instead of the acl, show which permissions the caller or a\n"
 "              specified user has for file(s).  When a list of groups is\n"
 "              given, this overrides the groups the user is in.\n"
+"  --effective, -e\n"
+"              Instead of the acl, show which permissions the owner, the\n"
+"              owning group, each user and group in the acl, and everyone\n"
+"              else have for file(s).\n"
 "  --version, -v\n"
 "              Display the version of %s and exit.\n"
 "  --help, -h  This help text.\n"
@@ -123,7 +218,7 @@ COMMON_HELP,
 
 int main(int argc, char *argv[])
 {
-	int opt_access = 0;
+	int opt_access = 0, opt_effective = 0, opt_cache_masks = 0;
 	char *opt_user = NULL;
 	int format = RICHACL_TEXT_SIMPLIFY | RICHACL_TEXT_ALIGN;
 	uid_t user = -1;
@@ -134,7 +229,7 @@ int main(int argc, char *argv[])
 
 	progname = argv[0];
 
-	while ((c = getopt_long(argc, argv, "a::lvh",
+	while ((c = getopt_long(argc, argv, "a::elvh",
 				long_options, NULL)) != -1) {
 		switch(c) {
 			case 'a':  /* --access */
@@ -142,6 +237,10 @@ int main(int argc, char *argv[])
 				opt_user = optarg;
 				break;
 
+			case 'e':  /* --effective */
+				opt_effective = 1;
+				break;
+
 			case 'l':  /* --long */
 				format |= RICHACL_TEXT_LONG;
 				break;
@@ -163,6 +262,10 @@ int main(int argc, char *argv[])
 				format |= RICHACL_TEXT_NUMERIC_IDS;
 				break;
 
+			case 6:  /* --cache-masks */
+				opt_cache_masks = 1;
+				break;
+
 			case 'v':
 				printf("%s %s\n", basename(progname), VERSION);
 				exit(0);
@@ -250,6 +353,15 @@ int main(int argc, char *argv[])
 	} else
 		user = geteuid();
 
+	if (opt_cache_masks && !opt_access && !opt_effective) {
+		masks_store = richacl_store_alloc();
+		if (!masks_store)
+			goto fail;
+		masks_cache = richacl_masks_cache_alloc(masks_store, 1024);
+		if (!masks_cache)
+			goto fail;
+	}
+
 	for (; optind < argc; optind++) {
 		const char *file = argv[optind];
 		struct richacl *acl = NULL;
@@ -277,7 +389,10 @@ int main(int argc, char *argv[])
 					goto fail3;
 				goto fail2;
 			}
-			if (print_richacl(file, &acl, &st, format))
+			if (opt_effective) {
+				if (print_effective(file, acl, &st, format))
+					goto fail2;
+			} else if (print_richacl(file, &acl, &st, format))
 				goto fail2;
 		}
 		richacl_free(acl);
@@ -289,6 +404,8 @@ int main(int argc, char *argv[])
 	fail3:
 		status = 1;
 	}
+	richacl_masks_cache_free(masks_cache);
+	richacl_store_free(masks_store);
 
 	return status;
 
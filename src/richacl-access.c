@@ -0,0 +1,103 @@
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+/*
+ * Count the memory allocations of the library by interposing the glibc
+ * allocator.
+ */
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static unsigned int allocations;
+
+void *malloc(size_t size)
+{
+	allocations++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	allocations++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	allocations++;
+	return __libc_realloc(ptr, size);
+}
+
+static gid_t *parse_groups(char *text, uid_t *user, int *n_groups)
+{
+	gid_t *groups;
+	char *tok;
+
+	groups = malloc(sizeof(gid_t) * (strlen(text) + 1));
+	if (!groups)
+		return NULL;
+	*user = strtoul(strtok(text, ":"), NULL, 10);
+	*n_groups = 0;
+	while ((tok = strtok(NULL, ":")))
+		groups[(*n_groups)++] = strtoul(tok, NULL, 10);
+	return groups;
+}
+
+int main(int argc, char *argv[])
+{
+	uid_t user = geteuid();
+	gid_t *groups = NULL;
+	int n_groups = -1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "u:")) != -1) {
+		switch(opt) {
+		case 'u':
+			groups = parse_groups(optarg, &user, &n_groups);
+			if (!groups)
+				goto fail;
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind == argc)
+		goto usage;
+
+	for (; optind < argc; optind++) {
+		const char *file = argv[optind];
+		unsigned int count;
+		char *text;
+		int allowed;
+
+		allocations = 0;
+		allowed = richacl_access(file, NULL, user, groups, n_groups);
+		count = allocations;
+		if (allowed < 0) {
+			perror(file);
+			continue;
+		}
+		text = richacl_mask_to_text(allowed, 0);
+		if (!text)
+			goto fail;
+		printf("%s: %s, %u allocations\n", file, *text ? text : "-", count);
+		free(text);
+	}
+	free(groups);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-u user[:group...]] file ...\n", argv[0]);
+	return 1;
+}
@@ -20,10 +20,19 @@ int main(int argc, char *argv[])
 {
 	uid_t owner = getuid();
 	mode_t mode = 0;
-	bool do_chmod = false, do_create = false;
-	int opt;
+	bool do_chmod = false, do_create = false, do_max_masks = false;
+	struct richacl_masks_cache *cache = NULL;
+	struct richacl_store *store = NULL;
+	mode_t *remask_modes;
+	int n_remask_modes = 0, opt;
 
-	while ((opt = getopt(argc, argv, "m:c:d")) != -1) {
+	remask_modes = calloc(argc, sizeof(*remask_modes));
+	if (!remask_modes) {
+		perror(argv[0]);
+		return 1;
+	}
+
+	while ((opt = getopt(argc, argv, "m:c:dxKr:")) != -1) {
 		switch(opt) {
 		case 'm':
 			mode = (mode & ~0777) | strtoul(optarg, NULL, 8);
@@ -39,6 +48,25 @@ int main(int argc, char *argv[])
 			mode |= S_IFDIR;
 			break;
 
+		case 'x':
+			do_max_masks = true;
+			break;
+
+		case 'K':
+			if (!store)
+				store = richacl_store_alloc();
+			if (store && !cache)
+				cache = richacl_masks_cache_alloc(store, 16);
+			if (!cache) {
+				perror(argv[0]);
+				return 1;
+			}
+			break;
+
+		case 'r':
+			remask_modes[n_remask_modes++] = strtoul(optarg, NULL, 8);
+			break;
+
 		default:
 			goto usage;
 		}
@@ -60,14 +88,77 @@ int main(int argc, char *argv[])
 			if (do_create)
 				acl->a_flags &= ~RICHACL_WRITE_THROUGH;
 		}
-		richacl_apply_masks(&acl, owner);
-		text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS);
+		if (n_remask_modes) {
+			struct richacl_remask *remask;
+			int n;
+
+			/*
+			 * Apply each mode like -m, but only repeat the steps
+			 * which depend on the masks.
+			 */
+			richacl_chmod(acl, (mode & S_IFDIR) | remask_modes[0]);
+			remask = richacl_remask_alloc(acl, owner);
+			if (!remask) {
+				perror(argv[0]);
+				return 1;
+			}
+			for (n = 0; n < n_remask_modes; n++) {
+				struct richacl *masked;
+
+				richacl_chmod(acl, (mode & S_IFDIR) |
+						   remask_modes[n]);
+				masked = richacl_remask(remask,
+							acl->a_owner_mask,
+							acl->a_group_mask,
+							acl->a_other_mask);
+				if (!masked) {
+					perror(argv[0]);
+					return 1;
+				}
+				text = richacl_to_text(masked,
+						       RICHACL_TEXT_NUMERIC_IDS);
+				printf("%s\n", text);
+				free(text);
+				richacl_free(masked);
+			}
+			richacl_remask_free(remask);
+			richacl_free(acl);
+			continue;
+		} else if (do_max_masks) {
+			/* Show the maximum masks instead of applying them. */
+			richacl_compute_max_masks(acl);
+			text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS |
+						    RICHACL_TEXT_SHOW_MASKS);
+		} else if (cache) {
+			const struct richacl *result, *again;
+			unsigned long hits, hits2;
+
+			/* The second time, the result comes from the cache. */
+			result = richacl_apply_masks_cache(cache, acl, owner);
+			richacl_masks_cache_stats(cache, &hits, NULL);
+			again = richacl_apply_masks_cache(cache, acl, owner);
+			richacl_masks_cache_stats(cache, &hits2, NULL);
+			if (!result || again != result || hits2 != hits + 1) {
+				perror(argv[0]);
+				return 1;
+			}
+			text = richacl_to_text(result, RICHACL_TEXT_NUMERIC_IDS);
+			richacl_intern_put(again);
+			richacl_intern_put(result);
+		} else {
+			richacl_apply_masks(&acl, owner);
+			text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS);
+		}
 		printf("%s\n", text);
 		free(text);
+		richacl_free(acl);
 	}
+	richacl_masks_cache_free(cache);
+	richacl_store_free(store);
+	free(remask_modes);
 	return 0;
 
 usage:
-	fprintf(stderr, "Usage: %s acl ...\n", argv[0]);
+	fprintf(stderr, "Usage: %s [-m mode] [-c mode] [-d] [-x] [-K] [-r mode ...] acl ...\n", argv[0]);
 	return 1;
 }
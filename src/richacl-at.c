@@ -0,0 +1,187 @@
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <sys/types.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sys/richacl.h"
+
+/* See lib/richacl_xattr_at.c. */
+#if !defined(SYS_getxattrat) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+#define SYS_setxattrat 463
+#define SYS_getxattrat 464
+#endif
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+/*
+ * Make the getxattrat() and setxattrat() system calls fail with @error
+ * like on a kernel without them (ENOSYS) or with a seccomp filter which
+ * does not know about them (EPERM), so that the library falls back to
+ * the path based calls.
+ */
+static int block_xattrat(int error)
+{
+#ifdef SYS_getxattrat
+	struct sock_filter filter[] = {
+		BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+			 offsetof(struct seccomp_data, nr)),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_getxattrat, 2, 0),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_setxattrat, 1, 0),
+		BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+		BPF_STMT(BPF_RET | BPF_K,
+			 SECCOMP_RET_ERRNO | (error & SECCOMP_RET_DATA)),
+	};
+	struct sock_fprog prog = {
+		.len = sizeof(filter) / sizeof(filter[0]),
+		.filter = filter,
+	};
+
+	if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) ||
+	    prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog))
+		return -1;
+#endif
+	/* Without the system calls, the library always falls back. */
+	return 0;
+}
+
+static void print_acl(const char *name, struct richacl *acl)
+{
+	char *text, *nl;
+
+	text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS);
+	if (!text) {
+		perror(name);
+		exit(1);
+	}
+	/* One entry per line; print the acl on a single line. */
+	while ((nl = strchr(text, '\n'))) {
+		if (nl[1])
+			*nl = ',';
+		else
+			*nl = 0;
+	}
+	printf("%s: %s\n", name, text);
+	free(text);
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl *acl = NULL;
+	const char *dir = NULL, *path = NULL;
+	int dirfd = AT_FDCWD, flags = 0, error = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:d:ef:np:")) != -1) {
+		switch(opt) {
+		case 'a':
+			acl = richacl_from_text(optarg, NULL, print_error);
+			if (!acl) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+
+		case 'd':
+			dir = optarg;
+			break;
+
+		case 'e':
+			flags |= AT_EMPTY_PATH;
+			break;
+
+		case 'f':
+			if (!strcmp(optarg, "ENOSYS"))
+				error = ENOSYS;
+			else if (!strcmp(optarg, "EPERM"))
+				error = EPERM;
+			else
+				goto usage;
+			break;
+
+		case 'n':
+			flags |= AT_SYMLINK_NOFOLLOW;
+			break;
+
+		case 'p':
+			path = optarg;
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind == argc || (dir && path))
+		goto usage;
+
+	if (dir) {
+		dirfd = open(dir, O_RDONLY | O_DIRECTORY);
+		if (dirfd < 0) {
+			perror(dir);
+			return 1;
+		}
+	} else if (path) {
+		dirfd = open(path, O_PATH |
+			     ((flags & AT_SYMLINK_NOFOLLOW) ? O_NOFOLLOW : 0));
+		if (dirfd < 0) {
+			perror(path);
+			return 1;
+		}
+	}
+	if (error && block_xattrat(error))
+		goto fail;
+
+	for (; optind < argc; optind++) {
+		const char *name = argv[optind];
+		const char *label = *name ? name : "\"\"";
+
+		if (acl) {
+			if (richacl_set_at(dirfd, name, acl, flags))
+				printf("%s: %s\n", label, strerror(errno));
+			else
+				printf("%s: ok\n", label);
+		} else {
+			struct richacl *file_acl;
+
+			file_acl = richacl_get_at(dirfd, name, flags);
+			if (file_acl) {
+				print_acl(label, file_acl);
+				richacl_free(file_acl);
+			} else if (errno == ENODATA || errno == ENOTSUP)
+				printf("%s: no acl\n", label);
+			else
+				printf("%s: %s\n", label, strerror(errno));
+		}
+	}
+
+	richacl_free(acl);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-f ENOSYS|EPERM] [-d dir|-p path] [-n] "
+			"[-e] [-a acl] file ...\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,706 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+static unsigned long iterations = 1000000;
+static volatile unsigned long sink;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct richacl *parse_acl(const char *text, mode_t mode)
+{
+	struct richacl *acl;
+
+	acl = richacl_from_text(text, NULL, print_error);
+	if (!acl) {
+		perror(text);
+		exit(1);
+	}
+	if (mode)
+		richacl_chmod(acl, S_IFREG | mode);
+	return acl;
+}
+
+static const struct {
+	const char *name;
+	const char *text;
+	mode_t mode;
+} shape_acls[] = {
+	{ "mode-equivalent",
+	  "owner@:rwp::allow,group@:r::allow,everyone@:r::allow", 0 },
+	{ "allow-only",
+	  "owner@:rwp::allow,user:1003:rw::allow,group:200:r::allow,"
+	  "group@:r::allow,everyone@:r::allow", 0 },
+	{ "deny",
+	  "user:1003:w::deny,group:300:w::deny,owner@:rwp::allow,"
+	  "group:200:r::allow,group@:r::allow,everyone@:r::allow", 0 },
+	{ "masked-write-through",
+	  "owner@:rwp::allow,user:1003:rw::allow,group:200:r::allow,"
+	  "group@:r::allow,everyone@:r::allow", 0640 },
+	{ "inherit-only",
+	  "owner@:rwp::allow,user:1003:rw:fi:allow,group:200:r:fi:allow,"
+	  "group@:r::allow,everyone@:r::allow", 0 },
+};
+
+static void bench_shape(void)
+{
+	static const gid_t groups[][2] = { { 100 }, { 100, 200 }, { 300 } };
+	struct richacl_cred *creds[3];
+	unsigned int mask = RICHACE_READ_DATA;
+	int n, k;
+
+	creds[0] = richacl_cred_alloc(1000, groups[0], 1);
+	creds[1] = richacl_cred_alloc(1001, groups[1], 2);
+	creds[2] = richacl_cred_alloc(1002, groups[2], 1);
+	if (!creds[0] || !creds[1] || !creds[2]) {
+		perror("richacl_cred_alloc");
+		exit(1);
+	}
+
+	printf("%-22s %6s %10s %10s\n", "shape", "flags", "cred ns", "shape ns");
+	for (n = 0; n < sizeof(shape_acls) / sizeof(shape_acls[0]); n++) {
+		struct richacl *acl = parse_acl(shape_acls[n].text,
+						shape_acls[n].mode);
+		unsigned int shape = richacl_shape(acl);
+		unsigned long i, count = 0;
+		double t0, t1, t2;
+
+		t0 = now();
+		for (i = 0; i < iterations; i++) {
+			for (k = 0; k < 3; k++)
+				count += richacl_permission_cred(acl, 1000,
+						100, creds[k], mask);
+		}
+		t1 = now();
+		for (i = 0; i < iterations; i++) {
+			for (k = 0; k < 3; k++)
+				count += richacl_permission_shape(acl, shape,
+						1000, 100, creds[k], mask);
+		}
+		t2 = now();
+		sink = count;
+		printf("%-22s %6x %10.1f %10.1f\n", shape_acls[n].name, shape,
+		       (t1 - t0) * 1e9 / (iterations * 3),
+		       (t2 - t1) * 1e9 / (iterations * 3));
+		richacl_free(acl);
+	}
+	for (k = 0; k < 3; k++)
+		richacl_cred_free(creds[k]);
+}
+
+/*
+ * An acl with @count entries: alternating user and group entries which do
+ * not match the benchmark process, followed by everyone@.
+ */
+static struct richacl *large_acl(unsigned int count)
+{
+	struct richacl *acl;
+	unsigned int n;
+
+	acl = richacl_alloc(count);
+	if (!acl) {
+		perror("richacl_alloc");
+		exit(1);
+	}
+	for (n = 0; n < count; n++) {
+		struct richace *ace = &acl->a_entries[n];
+
+		ace->e_type = RICHACE_ACCESS_ALLOWED_ACE_TYPE;
+		ace->e_mask = RICHACE_READ_DATA;
+		if (n == count - 1)
+			richace_set_special_who(ace, "EVERYONE@");
+		else if (n & 1)
+			richace_set_gid(ace, 2000 + n);
+		else
+			richace_set_uid(ace, 2000 + n);
+	}
+	return acl;
+}
+
+static void bench_packed(void)
+{
+	static const unsigned int counts[] = { 16, 256, 4096 };
+	static const gid_t groups[] = { 100 };
+	struct richacl_cred *cred;
+	unsigned int mask = RICHACE_READ_DATA;
+	int n;
+
+	cred = richacl_cred_alloc(1000, groups, 1);
+	if (!cred) {
+		perror("richacl_cred_alloc");
+		exit(1);
+	}
+
+	printf("%8s %10s %10s %10s %10s\n", "entries", "cred ns",
+	       "packed ns", "cred B/e", "packed B/e");
+	for (n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+		struct richacl *acl = large_acl(counts[n]);
+		struct richacl_packed *packed = richacl_pack(acl);
+		unsigned long i, count = 0, iters;
+		double t0, t1, t2;
+
+		if (!packed) {
+			perror("richacl_pack");
+			exit(1);
+		}
+		iters = iterations / counts[n] + 1;
+		t0 = now();
+		for (i = 0; i < iters; i++)
+			count += richacl_permission_cred(acl, 1000, 100, cred,
+							 mask);
+		t1 = now();
+		for (i = 0; i < iters; i++)
+			count += richacl_packed_permission(packed, 1000, 100,
+							   cred, mask);
+		t2 = now();
+		sink = count;
+		/* Bytes per entry which a scan for a non-matching user reads. */
+		printf("%8u %10.1f %10.1f %10zu %10zu\n", counts[n],
+		       (t1 - t0) * 1e9 / iters, (t2 - t1) * 1e9 / iters,
+		       sizeof(struct richace),
+		       sizeof(unsigned char) + sizeof(id_t));
+		richacl_packed_free(packed);
+		richacl_free(acl);
+	}
+	richacl_cred_free(cred);
+}
+
+static void bench_xattr(void)
+{
+	static const unsigned int counts[] = { 4, 32, 256 };
+	static const gid_t groups[] = { 100 };
+	struct richacl_cred *cred;
+	unsigned int mask = RICHACE_READ_DATA;
+	int n;
+
+	cred = richacl_cred_alloc(1000, groups, 1);
+	if (!cred) {
+		perror("richacl_cred_alloc");
+		exit(1);
+	}
+
+	printf("%8s %12s %10s\n", "entries", "decode ns", "view ns");
+	for (n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+		struct richacl *acl = large_acl(counts[n]);
+		size_t size = richacl_xattr_size(acl);
+		void *value = malloc(size);
+		unsigned long i, count = 0, iters;
+		double t0, t1, t2;
+
+		if (!value) {
+			perror("malloc");
+			exit(1);
+		}
+		richacl_to_xattr(acl, value);
+		iters = iterations / counts[n] + 1;
+		t0 = now();
+		for (i = 0; i < iters; i++) {
+			struct richacl *decoded = richacl_from_xattr(value, size);
+
+			count += richacl_permission_cred(decoded, 1000, 100,
+							 cred, mask);
+			richacl_free(decoded);
+		}
+		t1 = now();
+		for (i = 0; i < iters; i++) {
+			struct richacl_xattr_view view;
+
+			richacl_xattr_view_init(&view, value, size);
+			count += richacl_xattr_view_permission(&view, 1000, 100,
+							       cred, mask);
+		}
+		t2 = now();
+		sink = count;
+		printf("%8u %12.1f %10.1f\n", counts[n],
+		       (t1 - t0) * 1e9 / iters, (t2 - t1) * 1e9 / iters);
+		free(value);
+		richacl_free(acl);
+	}
+	richacl_cred_free(cred);
+}
+
+/*
+ * Encode and decode acls of various sizes, per entry.
+ */
+static void bench_codec(void)
+{
+	static const unsigned int counts[] = { 4, 32, 256, 4096 };
+	int n;
+
+	printf("%8s %10s %10s\n", "entries", "encode ns", "decode ns");
+	for (n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+		struct richacl *acl = large_acl(counts[n]);
+		size_t size, decoded_size;
+		void *value, *buffer;
+		unsigned long i, count = 0, iters, entries;
+		double t0, t1, t2;
+
+		size = richacl_xattr_size(acl);
+		value = malloc(size);
+		if (!value) {
+			perror("malloc");
+			exit(1);
+		}
+		richacl_to_xattr(acl, value);
+		decoded_size = richacl_xattr_decoded_size(value, size);
+		buffer = malloc(decoded_size);
+		if (!buffer) {
+			perror("malloc");
+			exit(1);
+		}
+		iters = iterations / counts[n] + 1;
+		t0 = now();
+		for (i = 0; i < iters; i++) {
+			richacl_to_xattr(acl, value);
+			count += *(unsigned char *)value;
+		}
+		t1 = now();
+		for (i = 0; i < iters; i++) {
+			struct richacl *acl2;
+
+			acl2 = richacl_from_xattr_buffer(value, size, buffer,
+							 decoded_size);
+			count += acl2->a_count;
+		}
+		t2 = now();
+		sink = count;
+		entries = counts[n];
+		printf("%8u %10.2f %10.2f\n", counts[n],
+		       (t1 - t0) * 1e9 / iters / entries,
+		       (t2 - t1) * 1e9 / iters / entries);
+		free(buffer);
+		free(value);
+		richacl_free(acl);
+	}
+}
+
+/*
+ * Intern the acls of many files, most of which have one of a few distinct
+ * acls, and compare the memory used with keeping a copy per file.
+ */
+static void bench_intern(void)
+{
+	enum { DISTINCT = 1000, ENTRIES = 8 };
+	struct richacl *acls[DISTINCT];
+	struct richacl_store *store;
+	const struct richacl **shared;
+	unsigned long files = iterations, i, acl_size;
+	double t0, t1;
+	int n;
+
+	store = richacl_store_alloc();
+	shared = malloc(files * sizeof(*shared));
+	if (!store || !shared) {
+		perror("richacl_store_alloc");
+		exit(1);
+	}
+	for (n = 0; n < DISTINCT; n++) {
+		acls[n] = large_acl(ENTRIES);
+		acls[n]->a_entries[0].e_id = n;
+	}
+	acl_size = sizeof(struct richacl) + ENTRIES * sizeof(struct richace);
+	t0 = now();
+	for (i = 0; i < files; i++) {
+		shared[i] = richacl_intern(store, acls[i % DISTINCT]);
+		if (!shared[i]) {
+			perror("richacl_intern");
+			exit(1);
+		}
+	}
+	t1 = now();
+	printf("%10s %10s %12s %12s\n", "files", "intern ns", "private KiB",
+	       "shared KiB");
+	printf("%10lu %10.1f %12lu %12lu\n", files, (t1 - t0) * 1e9 / files,
+	       files * acl_size / 1024,
+	       (files < DISTINCT ? files : DISTINCT) * acl_size / 1024);
+	for (i = 0; i < files; i++)
+		richacl_intern_put(shared[i]);
+	for (n = 0; n < DISTINCT; n++)
+		richacl_free(acls[n]);
+	free(shared);
+	richacl_store_free(store);
+}
+
+/*
+ * Compute the maximum masks of large_acl() with a group@ deny entry in
+ * front: for such acls, the permissions allowed to the group class need to
+ * be computed as well.  The time per entry should not grow with the acl
+ * size.
+ */
+static void bench_maxmasks(void)
+{
+	static const unsigned int counts[] = { 10, 100, 1000, 5000 };
+	int n;
+
+	printf("%8s %12s %10s\n", "entries", "ns", "ns/entry");
+	for (n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+		struct richacl *acl = large_acl(counts[n]);
+		unsigned long i, iters;
+		double t0, t1;
+
+		acl->a_entries[0].e_type = RICHACE_ACCESS_DENIED_ACE_TYPE;
+		acl->a_entries[0].e_mask = RICHACE_WRITE_DATA;
+		richace_set_special_who(&acl->a_entries[0], "GROUP@");
+		iters = iterations / counts[n] + 1;
+		t0 = now();
+		for (i = 0; i < iters; i++)
+			richacl_compute_max_masks(acl);
+		t1 = now();
+		sink = acl->a_group_mask;
+		printf("%8u %12.1f %10.2f\n", counts[n],
+		       (t1 - t0) * 1e9 / iters,
+		       (t1 - t0) * 1e9 / iters / counts[n]);
+		richacl_free(acl);
+	}
+}
+
+/*
+ * Apply the masks of large_acl() after a chmod, for a file and for a
+ * directory with inheritable entries.  The time per entry should not grow
+ * with the acl size.
+ */
+static void bench_applymasks(void)
+{
+	static const unsigned int counts[] = { 10, 100, 1000, 5000 };
+	int n, dir;
+
+	printf("%8s %10s %12s %10s %8s\n", "entries", "type", "ns",
+	       "ns/entry", "result");
+	for (n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+		for (dir = 0; dir < 2; dir++) {
+			struct richacl *acl = large_acl(counts[n]), *masked;
+			unsigned long i, iters, result = 0;
+			struct richace *ace;
+			double t0, t1;
+
+			richacl_for_each_entry(ace, acl) {
+				ace->e_mask |= RICHACE_WRITE_DATA;
+				if (dir)
+					ace->e_flags |=
+						RICHACE_FILE_INHERIT_ACE |
+						RICHACE_DIRECTORY_INHERIT_ACE;
+			}
+			richacl_chmod(acl, (dir ? S_IFDIR : S_IFREG) | 0640);
+			iters = iterations / counts[n] / 10 + 1;
+			t0 = now();
+			for (i = 0; i < iters; i++) {
+				masked = richacl_clone(acl);
+				if (!masked || richacl_apply_masks(&masked, 0)) {
+					perror("richacl_apply_masks");
+					exit(1);
+				}
+				result = masked->a_count;
+				richacl_free(masked);
+			}
+			t1 = now();
+			printf("%8u %10s %12.1f %10.2f %8lu\n", counts[n],
+			       dir ? "directory" : "file",
+			       (t1 - t0) * 1e9 / iters,
+			       (t1 - t0) * 1e9 / iters / counts[n], result);
+			richacl_free(acl);
+		}
+	}
+}
+
+/*
+ * Apply the masks to the acls of many files, most of which have one of a
+ * few distinct acls, with and without remembering the results.
+ */
+static void bench_maskscache(void)
+{
+	enum { DISTINCT = 100, ENTRIES = 20 };
+	struct richacl *acls[DISTINCT];
+	struct richacl_masks_cache *cache;
+	struct richacl_store *store;
+	unsigned long files = iterations / 10, i, hits, misses;
+	double t0, t1, t2;
+	int n;
+
+	store = richacl_store_alloc();
+	cache = store ? richacl_masks_cache_alloc(store, 4 * DISTINCT) : NULL;
+	if (!cache) {
+		perror("richacl_masks_cache_alloc");
+		exit(1);
+	}
+	for (n = 0; n < DISTINCT; n++) {
+		struct richace *ace;
+
+		acls[n] = large_acl(ENTRIES);
+		acls[n]->a_entries[0].e_id = n;
+		richacl_for_each_entry(ace, acls[n])
+			ace->e_mask |= RICHACE_WRITE_DATA;
+		richacl_chmod(acls[n], S_IFREG | 0640);
+	}
+	t0 = now();
+	for (i = 0; i < files; i++) {
+		struct richacl *masked = richacl_clone(acls[i % DISTINCT]);
+
+		if (!masked || richacl_apply_masks(&masked, 0)) {
+			perror("richacl_apply_masks");
+			exit(1);
+		}
+		richacl_free(masked);
+	}
+	t1 = now();
+	for (i = 0; i < files; i++) {
+		const struct richacl *masked;
+
+		masked = richacl_apply_masks_cache(cache, acls[i % DISTINCT], 0);
+		if (!masked) {
+			perror("richacl_apply_masks_cache");
+			exit(1);
+		}
+		richacl_intern_put(masked);
+	}
+	t2 = now();
+	richacl_masks_cache_stats(cache, &hits, &misses);
+	printf("%10s %12s %12s %10s %10s\n", "files", "apply ns", "cached ns",
+	       "hits", "misses");
+	printf("%10lu %12.1f %12.1f %10lu %10lu\n", files,
+	       (t1 - t0) * 1e9 / files, (t2 - t1) * 1e9 / files, hits, misses);
+	for (n = 0; n < DISTINCT; n++)
+		richacl_free(acls[n]);
+	richacl_masks_cache_free(cache);
+	richacl_store_free(store);
+}
+
+/*
+ * Apply a few different modes to large_acl() in turn, with chmod and
+ * richacl_apply_masks(), and with richacl_remask().
+ */
+static void bench_remask(void)
+{
+	static const unsigned int counts[] = { 10, 100, 1000, 5000 };
+	static const mode_t modes[] = { 0640, 0644, 0660, 0600 };
+	int n;
+
+	printf("%8s %12s %12s\n", "entries", "apply ns", "remask ns");
+	for (n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+		struct richacl *acl = large_acl(counts[n]), *masked;
+		struct richacl_remask *remask;
+		unsigned long i, iters;
+		struct richace *ace;
+		double t0, t1, t2;
+
+		richacl_for_each_entry(ace, acl)
+			ace->e_mask |= RICHACE_WRITE_DATA;
+		richacl_chmod(acl, S_IFREG | modes[0]);
+		remask = richacl_remask_alloc(acl, 0);
+		if (!remask) {
+			perror("richacl_remask_alloc");
+			exit(1);
+		}
+		iters = iterations / counts[n] / 10 + 1;
+		t0 = now();
+		for (i = 0; i < iters; i++) {
+			masked = richacl_clone(acl);
+			if (!masked) {
+				perror("richacl_clone");
+				exit(1);
+			}
+			richacl_chmod(masked, S_IFREG | modes[i % 4]);
+			if (richacl_apply_masks(&masked, 0)) {
+				perror("richacl_apply_masks");
+				exit(1);
+			}
+			richacl_free(masked);
+		}
+		t1 = now();
+		for (i = 0; i < iters; i++) {
+			/* Only used for computing the masks */
+			richacl_chmod(acl, S_IFREG | modes[i % 4]);
+			masked = richacl_remask(remask, acl->a_owner_mask,
+						acl->a_group_mask,
+						acl->a_other_mask);
+			if (!masked) {
+				perror("richacl_remask");
+				exit(1);
+			}
+			richacl_free(masked);
+		}
+		t2 = now();
+		printf("%8u %12.1f %12.1f\n", counts[n],
+		       (t1 - t0) * 1e9 / iters, (t2 - t1) * 1e9 / iters);
+		richacl_remask_free(remask);
+		richacl_free(acl);
+	}
+}
+
+static unsigned long queue_done;
+
+static void count_done(void *data, struct richacl *acl, const struct stat *st,
+		       int error)
+{
+	if (error) {
+		fprintf(stderr, "%s: %s\n", (char *)data, strerror(error));
+		exit(1);
+	}
+	richacl_free(acl);
+	queue_done++;
+}
+
+/*
+ * Files per second read and written through richacl_queue_*(), synchronously
+ * and through io_uring with different queue depths.  Uses the user.richacl
+ * xattr in a temporary directory under the current directory, so that the
+ * benchmark also runs on file systems without richacl support.
+ */
+static void bench_queue(void)
+{
+	static const struct {
+		const char *name;
+		unsigned int depth;
+		int flags;
+	} modes[] = {
+		{ "sync", 1, RICHACL_QUEUE_SYNC },
+		{ "ring-16", 16, 0 },
+		{ "ring-64", 64, 0 },
+		{ "ring-256", 256, 0 },
+	};
+	unsigned long files = iterations / 100 + 1, i;
+	struct richacl *acl = large_acl(8);
+	char dir[] = "richacl-bench.XXXXXX";
+	char **names;
+	int n;
+
+	names = calloc(files, sizeof(*names));
+	if (!names || !mkdtemp(dir)) {
+		perror(dir);
+		exit(1);
+	}
+	for (i = 0; i < files; i++) {
+		int fd;
+
+		names[i] = malloc(sizeof(dir) + 3 * sizeof(i));
+		if (!names[i]) {
+			perror("malloc");
+			exit(1);
+		}
+		sprintf(names[i], "%s/%lu", dir, i);
+		fd = creat(names[i], 0644);
+		if (fd < 0) {
+			perror(names[i]);
+			exit(1);
+		}
+		close(fd);
+	}
+
+	printf("%d files\n", (int)files);
+	printf("%10s %12s %12s\n", "mode", "set files/s", "get files/s");
+	for (n = 0; n < sizeof(modes) / sizeof(modes[0]); n++) {
+		struct richacl_queue *q;
+		double t0, t1, t2;
+
+		q = richacl_queue_alloc(modes[n].depth, "user.richacl",
+					modes[n].flags, count_done);
+		if (!q) {
+			perror("richacl_queue_alloc");
+			exit(1);
+		}
+		queue_done = 0;
+		t0 = now();
+		for (i = 0; i < files; i++)
+			richacl_queue_set_file(q, names[i], acl, names[i]);
+		richacl_queue_wait(q);
+		t1 = now();
+		for (i = 0; i < files; i++)
+			richacl_queue_get_file(q, names[i], RICHACL_QUEUE_STAT,
+					       names[i]);
+		richacl_queue_wait(q);
+		t2 = now();
+		richacl_queue_free(q);
+		if (queue_done != 2 * files) {
+			fprintf(stderr, "%s: %lu requests completed\n",
+				modes[n].name, queue_done);
+			exit(1);
+		}
+		printf("%10s %12.0f %12.0f\n", modes[n].name,
+		       files / (t1 - t0), files / (t2 - t1));
+	}
+
+	for (i = 0; i < files; i++) {
+		unlink(names[i]);
+		free(names[i]);
+	}
+	rmdir(dir);
+	free(names);
+	richacl_free(acl);
+}
+
+static const struct {
+	const char *name;
+	void (*run)(void);
+} benchmarks[] = {
+	{ "shape", bench_shape },
+	{ "packed", bench_packed },
+	{ "xattr", bench_xattr },
+	{ "codec", bench_codec },
+	{ "intern", bench_intern },
+	{ "maxmasks", bench_maxmasks },
+	{ "applymasks", bench_applymasks },
+	{ "maskscache", bench_maskscache },
+	{ "remask", bench_remask },
+	{ "queue", bench_queue },
+};
+
+int main(int argc, char *argv[])
+{
+	int opt, n, found;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch(opt) {
+		case 'n':
+			iterations = strtoul(optarg, NULL, 10);
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind == argc)
+		goto usage;
+
+	for (; optind < argc; optind++) {
+		found = 0;
+		for (n = 0; n < sizeof(benchmarks) / sizeof(benchmarks[0]); n++) {
+			if (!strcmp(argv[optind], benchmarks[n].name)) {
+				benchmarks[n].run();
+				found = 1;
+			}
+		}
+		if (!found)
+			goto usage;
+	}
+	return 0;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n iterations] benchmark ...\n"
+			"Benchmarks:", argv[0]);
+	for (n = 0; n < sizeof(benchmarks) / sizeof(benchmarks[0]); n++)
+		fprintf(stderr, " %s", benchmarks[n].name);
+	fprintf(stderr, "\n");
+	return 1;
+}
@@ -0,0 +1,125 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+/*
+ * Parse "index,...=acl" (with entries) or "index,..." (without): return the
+ * indices and the entries of the acl.
+ */
+static int parse_change(char *text, bool with_entries, unsigned int **indices,
+			unsigned int *count, struct richacl **acl)
+{
+	char *entries = NULL, *tok;
+
+	if (with_entries) {
+		entries = strchr(text, '=');
+		if (!entries)
+			return -1;
+		*entries++ = 0;
+	}
+	*indices = malloc(sizeof(**indices) * (strlen(text) + 1));
+	if (!*indices)
+		return -1;
+	*count = 0;
+	for (tok = strtok(text, ","); tok; tok = strtok(NULL, ","))
+		(*indices)[(*count)++] = strtoul(tok, NULL, 10);
+	*acl = NULL;
+	if (entries) {
+		*acl = richacl_from_text(entries, NULL, print_error);
+		if (!*acl)
+			return -1;
+		if ((*acl)->a_count != *count) {
+			fprintf(stderr, "%s: %u indices for %u entries\n",
+				entries, *count, (*acl)->a_count);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl_builder *builder;
+	struct richacl *acl, *changes;
+	unsigned int *indices, count;
+	char *text;
+	int opt, n;
+
+	/* Check the arguments before starting to change the acl. */
+	while ((opt = getopt(argc, argv, "i:d:r:")) != -1) {
+		if (opt == '?')
+			goto usage;
+	}
+	if (optind + 1 != argc)
+		goto usage;
+
+	acl = richacl_from_text(argv[optind], NULL, print_error);
+	if (!acl) {
+		perror(argv[optind]);
+		return 1;
+	}
+	builder = richacl_builder_alloc(acl);
+	if (!builder)
+		goto fail;
+
+	/* Apply the changes in the order given. */
+	optind = 1;
+	while ((opt = getopt(argc, argv, "i:d:r:")) != -1) {
+		if (parse_change(optarg, opt != 'd', &indices, &count,
+				 &changes)) {
+			perror(optarg);
+			return 1;
+		}
+		switch(opt) {
+		case 'i':
+			n = richacl_builder_insert(builder, indices,
+						   changes->a_entries, count);
+			break;
+
+		case 'd':
+			richacl_builder_delete(builder, indices, count);
+			n = 0;
+			break;
+
+		case 'r':
+			n = richacl_builder_replace(builder, indices,
+						    changes->a_entries, count);
+			break;
+		}
+		if (n)
+			goto fail;
+		richacl_free(changes);
+		free(indices);
+	}
+
+	acl = richacl_builder_finish(builder);
+	text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS);
+	if (!text)
+		goto fail;
+	printf("%s", text);
+	free(text);
+	richacl_free(acl);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-i index,...=acl] [-d index,...] "
+			"[-r index,...=acl] ... acl\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,190 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+static void print_acl(const char *name, struct richacl *acl)
+{
+	char *text, *nl;
+
+	text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS);
+	if (!text) {
+		perror(name);
+		exit(1);
+	}
+	/* One entry per line; print the acl on a single line. */
+	while ((nl = strchr(text, '\n'))) {
+		if (nl[1])
+			*nl = ',';
+		else
+			*nl = 0;
+	}
+	printf("%s: %s\n", name, text);
+	free(text);
+}
+
+static struct richacl_cred *parse_cred(char *text)
+{
+	struct richacl_cred *cred;
+	gid_t *groups;
+	uid_t user;
+	char *tok;
+	int n_groups = 0;
+
+	groups = malloc(sizeof(gid_t) * (strlen(text) + 1));
+	if (!groups)
+		return NULL;
+	user = strtoul(strtok(text, ":"), NULL, 10);
+	while ((tok = strtok(NULL, ":")))
+		groups[n_groups++] = strtoul(tok, NULL, 10);
+	cred = richacl_cred_alloc(user, groups, n_groups);
+	free(groups);
+	return cred;
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl *acl = NULL;
+	struct richacl_cred *cred = NULL;
+	struct richacl_pool *pool = NULL;
+	const char *dir = NULL;
+	unsigned int workers = 1;
+	int *dirfds = NULL, *errors, *granted;
+	struct richacl **acls;
+	const char *const *names;
+	int opt, n, count;
+
+	while ((opt = getopt(argc, argv, "a:d:u:w:")) != -1) {
+		switch(opt) {
+		case 'a':
+			acl = richacl_from_text(optarg, NULL, print_error);
+			if (!acl) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+
+		case 'd':
+			dir = optarg;
+			break;
+
+		case 'u':
+			cred = parse_cred(optarg);
+			if (!cred)
+				goto fail;
+			break;
+
+		case 'w':
+			workers = strtoul(optarg, NULL, 10);
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind == argc)
+		goto usage;
+	names = (const char *const *)argv + optind;
+	count = argc - optind;
+
+	errors = calloc(count, sizeof(*errors));
+	granted = calloc(count, sizeof(*granted));
+	acls = calloc(count, sizeof(*acls));
+	if (!errors || !granted || !acls)
+		goto fail;
+	if (workers != 1) {
+		pool = richacl_pool_alloc(workers);
+		if (!pool)
+			goto fail;
+	}
+	if (dir) {
+		int fd = open(dir, O_RDONLY | O_DIRECTORY);
+
+		dirfds = calloc(count, sizeof(*dirfds));
+		if (fd < 0 || !dirfds) {
+			perror(dir);
+			return 1;
+		}
+		for (n = 0; n < count; n++)
+			dirfds[n] = fd;
+	}
+
+	if (acl) {
+		/* The same acl for all files. */
+		for (n = 0; n < count; n++)
+			acls[n] = acl;
+		if (richacl_bulk_set(pool, count, dirfds, names, 0,
+				     (const struct richacl *const *)acls,
+				     errors)) {
+			for (n = 0; n < count; n++) {
+				if (errors[n])
+					fprintf(stderr, "%s: %s\n", names[n],
+						strerror(errors[n]));
+			}
+			return 1;
+		}
+	}
+
+	if (cred) {
+		richacl_bulk_access(pool, count, dirfds, names, 0, cred,
+				    granted, errors);
+		for (n = 0; n < count; n++) {
+			char *text;
+
+			if (errors[n]) {
+				printf("%s: %s\n", names[n],
+				       strerror(errors[n]));
+				continue;
+			}
+			text = richacl_mask_to_text(granted[n], 0);
+			if (!text)
+				goto fail;
+			printf("%s: %s\n", names[n], text);
+			free(text);
+		}
+	} else {
+		richacl_bulk_get(pool, count, dirfds, names, 0, acls, errors);
+		for (n = 0; n < count; n++) {
+			if (errors[n])
+				printf("%s: %s\n", names[n],
+				       strerror(errors[n]));
+			else {
+				print_acl(names[n], acls[n]);
+				richacl_free(acls[n]);
+			}
+		}
+	}
+
+	richacl_pool_free(pool);
+	richacl_cred_free(cred);
+	richacl_free(acl);
+	free(dirfds);
+	free(acls);
+	free(granted);
+	free(errors);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-w workers] [-d dir] [-a acl] "
+			"[-u user[:group...]] file ...\n", argv[0]);
+	return 1;
+}
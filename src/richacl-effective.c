@@ -0,0 +1,170 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+static void print_who(const struct richacl_effective *row)
+{
+	if (row->e_flags & RICHACE_SPECIAL_WHO) {
+		switch (row->e_id) {
+		case RICHACE_OWNER_SPECIAL_ID:
+			printf("owner@");
+			break;
+		case RICHACE_GROUP_SPECIAL_ID:
+			printf("group@");
+			break;
+		default:
+			printf("everyone@");
+			break;
+		}
+	} else if (row->e_flags & RICHACE_IDENTIFIER_GROUP)
+		printf("group:%d", row->e_id);
+	else
+		printf("user:%d", row->e_id);
+}
+
+/*
+ * Print the permissions richacl_xattr_view_access() grants the process
+ * "user[:group...]" in @text, for comparing with the effective permissions.
+ */
+static int print_access(const struct richacl *acl, const struct stat *st,
+			char *text)
+{
+	struct richacl_xattr_view view;
+	struct richacl_cred *cred;
+	gid_t *groups;
+	uid_t user;
+	int n_groups = 0, allowed;
+	char *tok, *mask;
+	size_t size;
+	void *xattr;
+
+	groups = malloc(sizeof(gid_t) * (strlen(text) + 1));
+	if (!groups)
+		return -1;
+	user = strtoul(strtok(text, ":"), NULL, 10);
+	while ((tok = strtok(NULL, ":")))
+		groups[n_groups++] = strtoul(tok, NULL, 10);
+	cred = richacl_cred_alloc(user, groups, n_groups);
+	free(groups);
+	if (!cred)
+		return -1;
+
+	size = richacl_xattr_size(acl);
+	xattr = malloc(size);
+	if (!xattr)
+		return -1;
+	richacl_to_xattr(acl, xattr);
+	if (richacl_xattr_view_init(&view, xattr, size))
+		return -1;
+	allowed = richacl_xattr_view_access(&view, st, cred);
+	if (allowed < 0)
+		return -1;
+	mask = richacl_mask_to_text(allowed, S_ISDIR(st->st_mode) ?
+				    RICHACL_TEXT_DIRECTORY_CONTEXT :
+				    RICHACL_TEXT_FILE_CONTEXT);
+	if (!mask)
+		return -1;
+	printf("user:%d access:%s\n", user, mask);
+	free(mask);
+	free(xattr);
+	richacl_cred_free(cred);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl *acl;
+	struct richacl_effective *matrix;
+	struct stat st = { .st_mode = S_IFREG };
+	bool do_chmod = false;
+	char *process = NULL;
+	unsigned int count, n;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "dm:o:g:u:")) != -1) {
+		switch(opt) {
+		case 'd':
+			st.st_mode = S_IFDIR | (st.st_mode & 07777);
+			break;
+
+		case 'm':
+			st.st_mode = (st.st_mode & ~07777) |
+				     strtoul(optarg, NULL, 8);
+			do_chmod = true;
+			break;
+
+		case 'o':
+			st.st_uid = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'g':
+			st.st_gid = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'u':
+			process = optarg;
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind + 1 != argc)
+		goto usage;
+
+	acl = richacl_from_text(argv[optind], NULL, print_error);
+	if (!acl) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	if (do_chmod)
+		richacl_chmod(acl, st.st_mode);
+
+	matrix = richacl_effective(acl, &st, &count);
+	if (!matrix)
+		goto fail;
+	for (n = 0; n < count; n++) {
+		char *text;
+
+		text = richacl_mask_to_text(matrix[n].e_mask,
+				S_ISDIR(st.st_mode) ?
+				RICHACL_TEXT_DIRECTORY_CONTEXT :
+				RICHACL_TEXT_FILE_CONTEXT);
+		if (!text)
+			goto fail;
+		print_who(&matrix[n]);
+		printf(":%s\n", text);
+		free(text);
+	}
+	free(matrix);
+	if (process && print_access(acl, &st, process))
+		goto fail;
+	richacl_free(acl);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-d] [-m mode] [-o owner] [-g group] "
+			"[-u user[:group...]] acl\n",
+		argv[0]);
+	return 1;
+}
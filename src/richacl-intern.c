@@ -0,0 +1,95 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl_store *store;
+	const struct richacl **shared;
+	unsigned long acls, hits, misses;
+	int n, k, count;
+
+	if (argc < 2)
+		goto usage;
+	count = argc - 1;
+	shared = calloc(count, sizeof(*shared));
+	store = richacl_store_alloc();
+	if (!shared || !store)
+		goto fail;
+
+	/* Print which of the previous acls each acl shares its copy with. */
+	for (n = 0; n < count; n++) {
+		struct richacl *acl;
+
+		acl = richacl_from_text(argv[n + 1], NULL, print_error);
+		if (!acl) {
+			perror(argv[n + 1]);
+			return 1;
+		}
+		shared[n] = richacl_intern(store, acl);
+		if (!shared[n])
+			goto fail;
+		richacl_free(acl);
+		for (k = 0; shared[k] != shared[n]; k++)
+			;
+		printf("%d: %d\n", n, k);
+	}
+	richacl_store_stats(store, &acls, &hits, &misses);
+	printf("acls: %lu hits: %lu misses: %lu\n", acls, hits, misses);
+
+	/*
+	 * Change a private copy of the first acl; the shared acl and the acls
+	 * sharing it must not change.
+	 */
+	if (shared[0]->a_count) {
+		const struct richacl *changed;
+		struct richacl *copy;
+
+		copy = richacl_clone(shared[0]);
+		if (!copy)
+			goto fail;
+		copy->a_entries[0].e_mask ^= RICHACE_APPEND_DATA;
+		changed = richacl_intern(store, copy);
+		if (!changed)
+			goto fail;
+		if (changed == shared[0] || richacl_equal(copy, shared[0])) {
+			fprintf(stderr, "%s: shared acl changed\n", argv[0]);
+			return 1;
+		}
+		richacl_free(copy);
+		richacl_intern_put(changed);
+	}
+
+	/* All references dropped: the store must be empty. */
+	for (n = 0; n < count; n++)
+		richacl_intern_put(shared[n]);
+	richacl_store_stats(store, &acls, NULL, NULL);
+	if (acls) {
+		fprintf(stderr, "%s: %lu acls left\n", argv[0], acls);
+		return 1;
+	}
+	richacl_store_free(store);
+	free(shared);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s acl ...\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,154 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+/* Encode @acl and decode it again, like getrichacl reads acls from files. */
+static struct richacl *round_trip(const struct richacl *acl)
+{
+	size_t size = richacl_xattr_size(acl);
+	struct richacl *decoded;
+	void *value;
+
+	value = malloc(size);
+	if (!value)
+		return NULL;
+	richacl_to_xattr(acl, value);
+	decoded = richacl_from_xattr(value, size);
+	free(value);
+	return decoded;
+}
+
+static char *acl_text(const struct richacl *acl)
+{
+	char *text, *nl;
+
+	text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS);
+	/* One entry per line; print the acl on a single line. */
+	while (text && (nl = strchr(text, '\n'))) {
+		if (nl[1])
+			*nl = ',';
+		else
+			*nl = 0;
+	}
+	return text;
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl_masks_cache *cache;
+	struct richacl_store *store;
+	uid_t owner = getuid();
+	unsigned long hits, misses;
+	mode_t mode = 0;
+	bool do_chmod = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:do:")) != -1) {
+		switch(opt) {
+		case 'm':
+			mode = (mode & ~0777) | strtoul(optarg, NULL, 8);
+			do_chmod = true;
+			break;
+
+		case 'd':
+			mode |= S_IFDIR;
+			break;
+
+		case 'o':
+			owner = strtoul(optarg, NULL, 10);
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind == argc)
+		goto usage;
+
+	store = richacl_store_alloc();
+	if (!store)
+		goto fail;
+	cache = richacl_masks_cache_alloc(store, 16);
+	if (!cache)
+		goto fail;
+
+	for (; optind < argc; optind++) {
+		char *arg = argv[optind], *eq = strchr(arg, '=');
+		uid_t acl_owner = owner;
+		struct richacl *acl, *decoded;
+		const struct richacl *cached;
+		char *text, *expected;
+
+		/* "owner=acl" overrides the owner for one acl. */
+		if (eq) {
+			*eq = 0;
+			acl_owner = strtoul(arg, NULL, 10);
+			arg = eq + 1;
+		}
+		acl = richacl_from_text(arg, NULL, print_error);
+		if (!acl) {
+			perror(arg);
+			return 1;
+		}
+		if (do_chmod)
+			richacl_chmod(acl, mode);
+
+		/* Apply the masks through the cache, and directly. */
+		decoded = round_trip(acl);
+		if (!decoded)
+			goto fail;
+		cached = richacl_apply_masks_cache(cache, decoded, acl_owner);
+		if (!cached)
+			goto fail;
+		richacl_free(decoded);
+		decoded = round_trip(acl);
+		if (!decoded || richacl_apply_masks(&decoded, acl_owner))
+			goto fail;
+
+		text = acl_text(cached);
+		expected = acl_text(decoded);
+		if (!text || !expected)
+			goto fail;
+		if (strcmp(text, expected)) {
+			fprintf(stderr, "%s: cached result %s differs from %s\n",
+				arg, text, expected);
+			return 1;
+		}
+		printf("%s\n", text);
+		free(expected);
+		free(text);
+		richacl_intern_put(cached);
+		richacl_free(decoded);
+		richacl_free(acl);
+	}
+
+	richacl_masks_cache_stats(cache, &hits, &misses);
+	printf("%lu hits, %lu misses\n", hits, misses);
+	richacl_masks_cache_free(cache);
+	richacl_store_free(store);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-m mode] [-d] [-o owner] "
+			"[owner=]acl ...\n", argv[0]);
+	return 1;
+}
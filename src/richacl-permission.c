@@ -0,0 +1,340 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+static int parse_mask(const char *text, unsigned int *mask)
+{
+	struct richacl *acl;
+	char *buffer;
+
+	buffer = malloc(strlen(text) + 20);
+	if (!buffer)
+		return -1;
+	sprintf(buffer, "everyone@:%s::allow", text);
+	acl = richacl_from_text(buffer, NULL, print_error);
+	free(buffer);
+	if (!acl)
+		return -1;
+	*mask = acl->a_entries[0].e_mask;
+	richacl_free(acl);
+	return 0;
+}
+
+struct process {
+	uid_t user;
+	gid_t *groups;
+	int n_groups;
+	struct richacl_cred *cred;
+};
+
+static int parse_process(char *text, struct process *process)
+{
+	char *tok;
+
+	process->n_groups = 0;
+	process->groups = malloc(sizeof(gid_t) * (strlen(text) + 1));
+	if (!process->groups)
+		return -1;
+	process->user = strtoul(strtok(text, ":"), NULL, 10);
+	while ((tok = strtok(NULL, ":")))
+		process->groups[process->n_groups++] = strtoul(tok, NULL, 10);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl *acl;
+	struct richacl_compiled *compiled = NULL;
+	struct richacl_packed *packed = NULL;
+	struct richacl_xattr_view view;
+	void *xattr = NULL;
+	mode_t mode = S_IFREG;
+	bool do_chmod = false, do_compile = false, do_cred = false;
+	bool do_many = false, do_vec = false, do_shape = false, do_pack = false;
+	bool do_view = false;
+	struct richacl_cache *cache = NULL;
+	struct process *processes;
+	int n_processes = 0;
+	uid_t owner = 0;
+	gid_t owning_group = 0;
+	unsigned int mask;
+	bool *allowed;
+	int opt, n;
+
+	processes = calloc(argc, sizeof(*processes));
+	allowed = calloc(argc, sizeof(*allowed));
+	if (!processes || !allowed)
+		goto fail;
+
+	while ((opt = getopt(argc, argv, "cCMVKSPXdm:o:g:u:")) != -1) {
+		switch(opt) {
+		case 'c':
+			do_compile = true;
+			break;
+
+		case 'C':
+			do_cred = true;
+			break;
+
+		case 'M':
+			do_many = true;
+			do_cred = true;
+			break;
+
+		case 'V':
+			do_vec = true;
+			do_cred = true;
+			break;
+
+		case 'K':
+			if (!cache)
+				cache = richacl_cache_alloc(16);
+			if (!cache)
+				goto fail;
+			do_cred = true;
+			break;
+
+		case 'S':
+			do_shape = true;
+			do_cred = true;
+			break;
+
+		case 'P':
+			do_pack = true;
+			do_cred = true;
+			break;
+
+		case 'X':
+			do_view = true;
+			do_cred = true;
+			break;
+
+		case 'd':
+			mode = S_IFDIR | (mode & 07777);
+			break;
+
+		case 'm':
+			mode = (mode & ~07777) | strtoul(optarg, NULL, 8);
+			do_chmod = true;
+			break;
+
+		case 'o':
+			owner = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'g':
+			owning_group = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'u':
+			if (parse_process(optarg, &processes[n_processes++]))
+				goto fail;
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind + 2 != argc)
+		goto usage;
+	if (!n_processes)
+		n_processes = 1;
+
+	acl = richacl_from_text(argv[optind], NULL, print_error);
+	if (!acl) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if (parse_mask(argv[optind + 1], &mask)) {
+		perror(argv[optind + 1]);
+		return 1;
+	}
+
+	if (do_chmod)
+		richacl_chmod(acl, mode);
+
+	for (n = 0; do_cred && n < n_processes; n++) {
+		struct process *p = &processes[n];
+
+		p->cred = richacl_cred_alloc(p->user, p->groups, p->n_groups);
+		if (!p->cred)
+			goto fail;
+	}
+
+	if (do_compile) {
+		compiled = richacl_compile(acl);
+		if (!compiled)
+			goto fail;
+	}
+
+	if (do_pack) {
+		struct richacl *unpacked;
+		struct richacl_packed *repacked;
+
+		/* Check that the acl survives a round trip. */
+		packed = richacl_pack(acl);
+		if (!packed)
+			goto fail;
+		unpacked = richacl_unpack(packed);
+		if (!unpacked)
+			goto fail;
+		repacked = richacl_pack(unpacked);
+		if (!repacked)
+			goto fail;
+		if (richacl_compare(acl, unpacked) ||
+		    richacl_packed_compare(packed, repacked) ||
+		    richacl_packed_hash(packed) != richacl_packed_hash(repacked) ||
+		    richacl_packed_hash(packed) != richacl_hash(acl)) {
+			fprintf(stderr, "%s: round trip failed\n", argv[0]);
+			return 1;
+		}
+		richacl_packed_free(repacked);
+		richacl_free(unpacked);
+	}
+
+	if (do_view) {
+		size_t size = richacl_xattr_size(acl);
+		struct richacl *decoded;
+		uint64_t hash;
+
+		xattr = malloc(size);
+		if (!xattr)
+			goto fail;
+		richacl_to_xattr(acl, xattr);
+		if (richacl_xattr_view_init(&view, xattr, size))
+			goto fail;
+		if (richacl_xattr_hash(xattr, size, &hash))
+			goto fail;
+		if (hash != richacl_hash(acl)) {
+			fprintf(stderr, "%s: xattr hash differs\n", argv[0]);
+			return 1;
+		}
+		decoded = richacl_from_xattr(xattr, size);
+		if (!decoded)
+			goto fail;
+		if (!richacl_equal(acl, decoded) ||
+		    richacl_hash(acl) != richacl_hash(decoded)) {
+			fprintf(stderr, "%s: decoded acl differs\n", argv[0]);
+			return 1;
+		}
+		richacl_free(decoded);
+		/* Check that the view shows the same entries. */
+		for (n = 0; n < acl->a_count; n++) {
+			struct richace ace;
+
+			richacl_xattr_view_entry(&view, n, &ace);
+			if (!richace_is_same_identifier(&ace,
+							&acl->a_entries[n]) ||
+			    ace.e_type != acl->a_entries[n].e_type ||
+			    ace.e_flags != acl->a_entries[n].e_flags ||
+			    ace.e_mask != acl->a_entries[n].e_mask) {
+				fprintf(stderr, "%s: entry %d differs\n",
+					argv[0], n);
+				return 1;
+			}
+		}
+	}
+
+	if (do_many) {
+		const struct richacl_cred **creds;
+
+		creds = calloc(n_processes, sizeof(*creds));
+		if (!creds)
+			goto fail;
+		for (n = 0; n < n_processes; n++)
+			creds[n] = processes[n].cred;
+		if (richacl_permission_many(acl, owner, owning_group, creds,
+					    n_processes, mask, allowed))
+			goto fail;
+		free(creds);
+	}
+
+	for (n = 0; n < n_processes; n++) {
+		struct process *p = &processes[n];
+
+		if (do_many)
+			/* already computed */ ;
+		else if (do_vec) {
+			const struct richacl *acls[] = { acl };
+
+			richacl_permission_vec(p->cred, acls, &owner,
+					       &owning_group, 1, mask,
+					       &allowed[n]);
+		} else if (do_view)
+			allowed[n] = richacl_xattr_view_permission(&view, owner,
+					owning_group, p->cred, mask);
+		else if (packed)
+			allowed[n] = richacl_packed_permission(packed, owner,
+					owning_group, p->cred, mask);
+		else if (do_shape)
+			allowed[n] = richacl_permission_shape(acl,
+					richacl_shape(acl), owner,
+					owning_group, p->cred, mask);
+		else if (cache) {
+			/* The second check is answered from the cache. */
+			allowed[n] = richacl_permission_cache(cache, acl,
+					owner, owning_group, p->cred, mask);
+			if (richacl_permission_cache(cache, acl, owner,
+					owning_group, p->cred, mask) !=
+			    allowed[n])
+				goto fail;
+		} else if (compiled && p->cred)
+			allowed[n] = richacl_compiled_permission_cred(compiled,
+					owner, owning_group, p->cred, mask);
+		else if (compiled)
+			allowed[n] = richacl_compiled_permission(compiled,
+					owner, owning_group, p->user,
+					p->groups, p->n_groups, mask);
+		else if (p->cred)
+			allowed[n] = richacl_permission_cred(acl, owner,
+					owning_group, p->cred, mask);
+		else
+			allowed[n] = richacl_permission(acl, owner,
+					owning_group, p->user, p->groups,
+					p->n_groups, mask);
+		printf("%s\n", allowed[n] ? "allowed" : "denied");
+		richacl_cred_free(p->cred);
+		free(p->groups);
+	}
+	if (cache) {
+		unsigned long hits, misses;
+
+		richacl_cache_stats(cache, &hits, &misses);
+		if (hits != (unsigned long)n_processes ||
+		    misses != (unsigned long)n_processes)
+			goto fail;
+		richacl_cache_free(cache);
+	}
+	free(xattr);
+	richacl_packed_free(packed);
+	richacl_compiled_free(compiled);
+	richacl_free(acl);
+	free(processes);
+	free(allowed);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-c] [-C] [-M] [-V] [-K] [-S] [-P] [-X] [-d] [-m mode] [-o owner] "
+			"[-g group] [-u user[:group...]] ... acl mask\n",
+		argv[0]);
+	return 1;
+}
@@ -0,0 +1,199 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sys/richacl.h"
+
+void print_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+struct result {
+	char *text;
+	mode_t mode;
+	int error;
+	bool done;
+};
+
+static struct richacl_queue *q;
+static char **names;
+static int *fds;
+static struct result *results;
+static int count, get_flags;
+static bool chain;
+
+static int queue_get(int n)
+{
+	return fds ?
+	       richacl_queue_get_fd(q, fds[n], get_flags, &results[n]) :
+	       richacl_queue_get_file(q, names[n], get_flags, &results[n]);
+}
+
+static void done(void *data, struct richacl *acl, const struct stat *st,
+		 int error)
+{
+	struct result *result = data;
+	char *nl;
+
+	result->done = true;
+	result->error = error;
+	if (st)
+		result->mode = st->st_mode;
+	if (acl) {
+		result->text = richacl_to_text(acl, RICHACL_TEXT_NUMERIC_IDS);
+		richacl_free(acl);
+		/* One entry per line; print the acl on a single line. */
+		while (result->text && (nl = strchr(result->text, '\n'))) {
+			if (nl[1])
+				*nl = ',';
+			else
+				*nl = 0;
+		}
+	}
+	/* With -c, each completed read queues the read of the next file. */
+	if (chain && result - results + 1 < count &&
+	    queue_get(result - results + 1)) {
+		perror("richacl_queue_get");
+		exit(1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	struct richacl *acl = NULL;
+	const char *name = NULL;
+	unsigned int depth = 4;
+	int flags = 0;
+	bool use_fds = false, use_chain = false;
+	int opt, n, status = 0;
+
+	while ((opt = getopt(argc, argv, "a:cd:fn:sS")) != -1) {
+		switch(opt) {
+		case 'a':
+			acl = richacl_from_text(optarg, NULL, print_error);
+			if (!acl) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+
+		case 'c':
+			use_chain = true;
+			break;
+
+		case 'd':
+			depth = strtoul(optarg, NULL, 10);
+			break;
+
+		case 'f':
+			use_fds = true;
+			break;
+
+		case 'n':
+			name = optarg;
+			break;
+
+		case 's':
+			flags |= RICHACL_QUEUE_SYNC;
+			break;
+
+		case 'S':
+			get_flags |= RICHACL_QUEUE_STAT;
+			break;
+
+		default:
+			goto usage;
+		}
+	}
+	if (optind == argc)
+		goto usage;
+	names = argv + optind;
+	count = argc - optind;
+
+	results = calloc(count, sizeof(*results));
+	q = richacl_queue_alloc(depth, name, flags, done);
+	if (!results || !q)
+		goto fail;
+	if (use_fds) {
+		fds = calloc(count, sizeof(*fds));
+		if (!fds)
+			goto fail;
+		for (n = 0; n < count; n++) {
+			fds[n] = open(argv[optind + n], O_RDONLY);
+			if (fds[n] < 0) {
+				perror(argv[optind + n]);
+				return 1;
+			}
+		}
+	}
+
+	if (acl) {
+		for (n = 0; n < count; n++) {
+			if (use_fds ?
+			    richacl_queue_set_fd(q, fds[n], acl, &results[n]) :
+			    richacl_queue_set_file(q, argv[optind + n], acl,
+						   &results[n]))
+				goto fail;
+		}
+		if (richacl_queue_wait(q))
+			goto fail;
+		for (n = 0; n < count; n++) {
+			if (!results[n].done)
+				goto fail;
+			if (results[n].error) {
+				fprintf(stderr, "%s: %s\n", argv[optind + n],
+					strerror(results[n].error));
+				status = 1;
+			}
+		}
+		if (status)
+			return status;
+		memset(results, 0, count * sizeof(*results));
+	}
+
+	chain = use_chain;
+	for (n = 0; n < (chain ? 1 : count); n++) {
+		if (queue_get(n))
+			goto fail;
+	}
+	if (richacl_queue_wait(q))
+		goto fail;
+	for (n = 0; n < count; n++) {
+		struct result *result = &results[n];
+
+		if (!result->done)
+			goto fail;
+		printf("%s:", argv[optind + n]);
+		if (get_flags & RICHACL_QUEUE_STAT)
+			printf(" %o", result->mode);
+		if (result->error)
+			printf(" %s\n", strerror(result->error));
+		else
+			printf(" %s\n", result->text);
+		free(result->text);
+	}
+	richacl_queue_free(q);
+	richacl_free(acl);
+	free(results);
+	free(fds);
+	return 0;
+
+fail:
+	perror(argv[0]);
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-s] [-f] [-S] [-c] [-d depth] [-n name] "
+			"[-a acl] file ...\n", argv[0]);
+	return 1;
+}
@@ -55,11 +55,6 @@ void printf_stderr(const char *fmt, ...)
 	va_end(ap);
 }
 
-#define richacl_for_each_entry_continue(_ace, _acl) \
-	for ((_ace)++; \
-	     (_ace) != (_acl)->a_entries + (_acl)->a_count; \
-	     (_ace)++)
-
 static void compute_masks(struct richacl *acl, int valid_in_acl, uid_t owner)
 {
 	unsigned int owner_mask = acl->a_owner_mask;
@@ -84,135 +79,220 @@ static void compute_masks(struct richacl *acl, int valid_in_acl, uid_t owner)
 		acl->a_other_mask = other_mask;
 }
 
-static int modify_richacl(struct richacl **acl2, struct richacl *acl, int valid_in_acl, uid_t owner)
+/*
+ * The kinds of entries modify_richacl() adds, in the order in which they
+ * end up when added in the same place.
+ */
+enum {
+	NEW_DENY,
+	NEW_ALLOW,
+	NEW_INHERITED_DENY,
+	NEW_INHERITED_ALLOW,
+	NEW_KINDS
+};
+
+static int new_kind(const struct richace *ace)
 {
-	struct richace *ace2, *ace;
+	return (richace_is_inherited(ace) ? NEW_INHERITED_DENY : NEW_DENY) +
+	       !richace_is_deny(ace);
+}
 
-	if (richacl_apply_masks(acl2, owner))
-		return -1;
+static bool same_entry(const struct richace *ace, const struct richace *ace2)
+{
+	return ace2->e_type == ace->e_type &&
+	       richace_is_inherited(ace2) == richace_is_inherited(ace) &&
+	       richace_is_same_identifier(ace, ace2);
+}
 
-	richacl_for_each_entry(ace, acl) {
-		struct richacl *acl3;
-		struct richace *ace3;
-		unsigned short count = (*acl2)->a_count;
-
-		richacl_for_each_entry(ace2, *acl2) {
-			if (ace2->e_type == ace->e_type &&
-			    richace_is_inherited(ace2) == richace_is_inherited(ace) &&
-			    richace_is_same_identifier(ace, ace2)) {
-				if (!ace->e_mask) {
-					count--;
-					break;
-				}
-				ace2->e_mask = ace->e_mask;
-				ace2->e_flags = ace->e_flags;
-				goto next_change;
-			}
+/*
+ * Changes to an acl, collected first and then applied all at once: @deleted
+ * tells which entries of @acl to delete, and the @count entries in @new go
+ * before the entries of @acl at the indices in @where.  @added counts the
+ * new entries of each kind before each entry of @acl.  New entries that
+ * are deleted again get a zero mask.
+ */
+struct changes {
+	struct richacl *acl;
+	bool *deleted;
+	unsigned int *added;
+	struct richace *new;
+	unsigned int *where;
+	unsigned int count;
+};
+
+static unsigned int added(struct changes *c, unsigned int i, int first, int last)
+{
+	unsigned int count = 0;
+
+	for (; first <= last; first++)
+		count += c->added[i * NEW_KINDS + first];
+	return count;
+}
+
+/*
+ * Find the index of the entry a new entry goes before: non-inherited deny
+ * entries go after the initial non-inherited deny entries, non-inherited
+ * allow entries at the end of the non-inherited entries, inherited deny
+ * entries after the initial deny entries among the trailing inherited
+ * entries, and inherited allow entries at the end of the acl.
+ */
+static unsigned int insert_where(struct changes *c, const struct richace *ace)
+{
+	struct richace *entries = c->acl->a_entries;
+	unsigned int n = c->acl->a_count, i, start = 0;
+
+	switch (new_kind(ace)) {
+	case NEW_DENY:
+		for (i = 0; i < n; i++) {
+			if (added(c, i, NEW_ALLOW, NEW_INHERITED_ALLOW) ||
+			    (!c->deleted[i] &&
+			     new_kind(&entries[i]) != NEW_DENY))
+				break;
 		}
+		return i;
 
-		if (ace->e_mask)
-			count++;
-		acl3 = richacl_alloc(count);
-		if (!acl3)
-			return -1;
-		acl3->a_flags = (*acl2)->a_flags;
-		ace3 = acl3->a_entries;
-
-		if (!ace->e_mask) {
-			richacl_for_each_entry(ace2, *acl2) {
-				if (ace2->e_type == ace->e_type &&
-				    richace_is_inherited(ace2) ==
-				    richace_is_inherited(ace) &&
-				    richace_is_same_identifier(ace, ace2))
-					continue;
-				if (richace_copy(ace3++, ace2))
-					goto fail;
+	case NEW_ALLOW:
+		for (i = 0; i < n; i++) {
+			if (added(c, i, NEW_INHERITED_DENY, NEW_INHERITED_ALLOW) ||
+			    (!c->deleted[i] && richace_is_inherited(&entries[i])))
+				break;
+		}
+		return i;
+
+	case NEW_INHERITED_DENY:
+		/* Find where the trailing inherited entries start. */
+		for (i = n + 1; i-- > 0; ) {
+			if (i < n && !c->deleted[i] &&
+			    !richace_is_inherited(&entries[i])) {
+				start = i + 1;
+				break;
 			}
-		} else if (!(ace->e_flags & RICHACE_INHERITED_ACE)) {
-			if (richace_is_deny(ace)) {
-				/*
-				 * Insert the new deny entry after the existing
-				 * initial non-inherited deny entries.
-				 */
-				richacl_for_each_entry(ace2, *acl2) {
-					if (!richace_is_deny(ace2) ||
-					    richace_is_inherited(ace2))
-						break;
-					if (richace_copy(ace3++, ace2))
-						goto fail;
-				}
-			} else {
-				/*
-				 * Append the new allow entry at the end of the
-				 * non-inherited aces.
-				 */
-				richacl_for_each_entry(ace2, *acl2) {
-					if (richace_is_inherited(ace2))
-						break;
-					if (richace_copy(ace3++, ace2))
-						goto fail;
-				}
+			if (added(c, i, NEW_DENY, NEW_ALLOW)) {
+				start = i;
+				break;
 			}
-			if (richace_copy(ace3++, ace))
-				goto fail;
-			ace2--;
-			richacl_for_each_entry_continue(ace2, *acl2)
-				if (richace_copy(ace3++, ace2))
-					goto fail;
-		} else {
-			struct richace *last_inherited;
+		}
+		for (i = start; i < n; i++) {
+			if (added(c, i, NEW_INHERITED_ALLOW, NEW_INHERITED_ALLOW) ||
+			    (!c->deleted[i] && !richace_is_deny(&entries[i])))
+				break;
+		}
+		return i;
 
-			last_inherited = (*acl2)->a_entries + (*acl2)->a_count;
-			while (last_inherited > (*acl2)->a_entries &&
-			       richace_is_inherited(last_inherited - 1))
-				last_inherited--;
+	default:
+		return n;
+	}
+}
 
-			richacl_for_each_entry(ace2, *acl2) {
-				if (ace2 == last_inherited)
-					break;
-				if (richace_copy(ace3++, ace2))
-					goto fail;
-			}
-			if (richace_is_deny(ace)) {
-				/*
-				 * Insert the new deny entry after the existing
-				 * initial inherited deny entries.
-				 */
-				ace2--;
-				richacl_for_each_entry_continue(ace2, *acl2) {
-					if (!richace_is_deny(ace2))
-						break;
-					if (richace_copy(ace3++, ace2))
-						goto fail;
-				}
-			} else {
-				/*
-				 * Append the new allow entry at the end of the
-				 * inherited aces.
-				 */
-				ace2--;
-				richacl_for_each_entry_continue(ace2, *acl2)
-					if (richace_copy(ace3++, ace2))
-						goto fail;
+/*
+ * Change, delete, or add the entries in @acl one after the other, as if the
+ * resulting acl was updated after each of them.  To avoid copying the acl
+ * for each entry added or deleted, the changes are collected first and then
+ * applied in a single pass.
+ */
+static int modify_richacl(struct richacl **acl2, struct richacl *acl, int valid_in_acl, uid_t owner)
+{
+	struct richacl_builder *builder = NULL;
+	struct richace *ace, *ace2, *aces = NULL;
+	unsigned int *which = NULL, *where = NULL;
+	unsigned int n, i, k, count, deleted;
+	struct changes c;
+	int ret = -1;
+
+	if (richacl_apply_masks(acl2, owner))
+		return -1;
+
+	n = (*acl2)->a_count;
+	c.acl = *acl2;
+	c.deleted = calloc(n + 1, sizeof(*c.deleted));
+	c.added = calloc((n + 1) * NEW_KINDS, sizeof(*c.added));
+	c.new = malloc((acl->a_count + 1) * sizeof(*c.new));
+	c.where = malloc((acl->a_count + 1) * sizeof(*c.where));
+	c.count = 0;
+	aces = malloc((acl->a_count + 1) * sizeof(*aces));
+	where = malloc((acl->a_count + 1) * sizeof(*where));
+	which = malloc((n + 1) * sizeof(*which));
+	if (!c.deleted || !c.added || !c.new || !c.where ||
+	    !aces || !where || !which)
+		goto out;
+
+	richacl_for_each_entry(ace, acl) {
+		bool found = false;
+
+		/* Several existing entries may match; they are all deleted. */
+		for (i = 0; i < n; i++) {
+			ace2 = &c.acl->a_entries[i];
+			if (c.deleted[i] || !same_entry(ace, ace2))
+				continue;
+			found = true;
+			if (!ace->e_mask) {
+				c.deleted[i] = true;
+				continue;
 			}
-			if (richace_copy(ace3++, ace))
-				goto fail;
-			ace2--;
-			richacl_for_each_entry_continue(ace2, *acl2)
-				if (richace_copy(ace3++, ace2))
-					goto fail;
+			ace2->e_mask = ace->e_mask;
+			ace2->e_flags = ace->e_flags;
+			break;
 		}
+		for (k = 0; !found && k < c.count; k++) {
+			ace2 = &c.new[k];
+			if (!ace2->e_mask || !same_entry(ace, ace2))
+				continue;
+			found = true;
+			if (!ace->e_mask)
+				c.added[c.where[k] * NEW_KINDS + new_kind(ace2)]--;
+			ace2->e_mask = ace->e_mask;
+			ace2->e_flags = ace->e_flags;
+		}
+		if (!found && ace->e_mask) {
+			c.where[c.count] = insert_where(&c, ace);
+			c.added[c.where[c.count] * NEW_KINDS + new_kind(ace)]++;
+			c.new[c.count++] = *ace;
+		}
+	}
 
-		richacl_free(*acl2);
-		*acl2 = acl3;
+	/*
+	 * Sort the new entries by where they go and by kind: turn the counts
+	 * in c.added into positions in the sorted list first.
+	 */
+	count = 0;
+	for (i = 0; i < (n + 1) * NEW_KINDS; i++) {
+		unsigned int added = c.added[i];
 
-	next_change:
-		continue;
+		c.added[i] = count;
+		count += added;
+	}
+	for (k = 0; k < c.count; k++) {
+		if (c.new[k].e_mask) {
+			i = c.added[c.where[k] * NEW_KINDS +
+				    new_kind(&c.new[k])]++;
+			aces[i] = c.new[k];
+			where[i] = c.where[k];
+		}
+	}
 
-	fail:
-		richacl_free(acl3);
-		return -1;
+	builder = richacl_builder_alloc(*acl2);
+	if (!builder)
+		goto out;
+	*acl2 = NULL;
+
+	/*
+	 * Delete entries first; the new entries then go before the remaining
+	 * entries at lower indices.
+	 */
+	for (k = 0, i = 0; i < n; i++) {
+		if (c.deleted[i])
+			which[k++] = i;
+	}
+	richacl_builder_delete(builder, which, k);
+	for (k = 0, i = 0, deleted = 0; k < count; k++) {
+		for (; i < where[k]; i++)
+			deleted += c.deleted[i];
+		where[k] -= deleted;
 	}
+	if (richacl_builder_insert(builder, where, aces, count))
+		goto out;
+	*acl2 = richacl_builder_finish(builder);
+	builder = NULL;
 
 	if (valid_in_acl & RICHACL_TEXT_FLAGS)
 		(*acl2)->a_flags = acl->a_flags;
@@ -223,8 +303,18 @@ static int modify_richacl(struct richacl **acl2, struct richacl *acl, int valid_
 	if (valid_in_acl & RICHACL_TEXT_OTHER_MASK)
 		(*acl2)->a_other_mask = acl->a_other_mask;
 	compute_masks(*acl2, valid_in_acl, owner);
-
-	return 0;
+	ret = 0;
+
+out:
+	richacl_builder_free(builder);
+	free(c.deleted);
+	free(c.added);
+	free(c.new);
+	free(c.where);
+	free(aces);
+	free(where);
+	free(which);
+	return ret;
 }
 
 static int auto_inherit(const char *dirname, struct richacl *dir_acl)